@@ -9,7 +9,7 @@
 #include <GLFW/glfw3.h>
 
 namespace glsl {
-    GLuint createShaderProgram(const char *vert_filename, const char *frag_filename);
+    GLuint createShaderProgram(const char *vert_filename, const char *frag_filename, const char *defines = NULL);
     void linkShaderProgram(GLuint program);
     void getShaderProgramUniforms(GLuint program, std::map<std::string,GLint>& uniforms);
 }
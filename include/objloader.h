@@ -16,19 +16,32 @@
 typedef struct Model
 {
     GLuint vertex_array;
+    GLuint vertex_position_buffer;
+    GLuint vertex_normal_buffer;
+    GLuint vertex_texcoord_buffer; // 0 if untextured
+    GLuint vertex_index_buffer;
     GLuint face_index_count;
+    glm::vec3 bbox_min;           // object-space bounds of the group
+    glm::vec3 bbox_max;
     std::string material_name;
 } Model;
 
 typedef struct Material
 {
     bool has_texture;
-    GLuint texture_id;
+    GLuint texture_id;            // 0 once released (see releaseTextures)
+    glm::vec4 texture_average;    // linear RGBA average of the texture
     glm::vec3 color;
     glm::vec3 specular;
     GLfloat shininess;
 } Material;
 
+typedef struct CachedTexture
+{
+    GLuint texture_id;
+    glm::vec4 average_color;
+} CachedTexture;
+
 typedef struct Face {
     GLuint vertex_indices[3];
     GLuint normal_indices[3];
@@ -50,6 +63,7 @@ private:
     glm::vec3 _center;
     glm::vec3 _size;
     unsigned int _num_triangles; 
+    static std::map<std::string, CachedTexture> _texture_cache;
 
     int findGroupByName(std::vector<Group> &groups, std::string material_name);
 
@@ -66,8 +80,10 @@ public:
                               std::vector<glm::vec2> &texcoords,
                               std::vector<Group> &groups);
     void loadMtl(const char *filename);
-    void createMaterialTexture(const char *filename, GLuint *texture_id);
+    void createMaterialTexture(const char *filename, GLuint *texture_id, glm::vec4 *average_color);
     std::vector<Model>& getModelList();
+    void releaseModelBuffers();
+    void releaseTextures();
     Material& getMaterial(std::string name);
     glm::vec3& getCenter();
     glm::vec3& getSize();
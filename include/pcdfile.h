@@ -0,0 +1,85 @@
+#ifndef PCD_FILE_H
+#define PCD_FILE_H
+
+#include <cstdint>
+
+// Chunked binary point cloud format (version 2)
+//
+// [PcdHeader][PcdChunk x num_chunks][chunk data ...]
+// Each chunk's data is stored contiguously at its offset as
+// centers (3 floats per point), colors (3 floats per point), sizes (1 float per point)
+
+#define PCD_MAGIC "PCD2"
+#define PCD_VERSION 2
+#define PCD_MAX_LIGHTS 10
+#define PCD_MAX_CHUNK_POINTS (1 << 26)  // keeps per-chunk reads and writes within an int count of floats
+
+typedef struct PcdLight {
+    float position[3];
+    float color[3];
+} PcdLight;
+
+typedef struct PcdHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t num_points;
+    uint64_t num_chunks;          // chunk table follows the header
+    float camera_position[3];
+    float camera_target[3];
+    uint32_t num_lights;
+    uint32_t reserved;
+    PcdLight lights[PCD_MAX_LIGHTS];
+} PcdHeader;
+
+typedef struct PcdChunk {
+    uint64_t num_points;
+    uint64_t offset;              // byte offset of the chunk's data from the start of the file
+    float bbox_min[3];
+    float bbox_max[3];
+} PcdChunk;
+
+static_assert(sizeof(PcdHeader) == 296, "PcdHeader must match the on-disk layout");
+static_assert(sizeof(PcdChunk) == 40, "PcdChunk must match the on-disk layout");
+
+// Octree point cloud format (version 1, written by pcd_octree)
+//
+// [PcdOctreeHeader][PcdOctreeNode x num_nodes][node data ...]
+// Nodes are stored depth first, so a node's subtree is the node and the following
+// subtree_nodes - 1 entries, and its points are a contiguous range of the node order.
+// Each node holds an even subsample of its subtree (all remaining points for leaves),
+// stored contiguously at its offset as centers, colors, sizes (like a chunk).
+
+#define PCD_OCTREE_MAGIC "PCO1"
+#define PCD_OCTREE_VERSION 1
+#define PCD_OCTREE_NODE_POINTS 16384    // most points in one node
+#define PCD_OCTREE_MAX_DEPTH 20
+
+typedef struct PcdOctreeHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t num_points;          // points stored in nodes
+    uint64_t num_nodes;           // node table follows the header
+    uint64_t dropped_points;      // coincident points beyond a full leaf at max depth
+    float camera_position[3];
+    float camera_target[3];
+    uint32_t num_lights;
+    uint32_t node_points;         // PCD_OCTREE_NODE_POINTS of the writer
+    PcdLight lights[PCD_MAX_LIGHTS];
+} PcdOctreeHeader;
+
+typedef struct PcdOctreeNode {
+    uint64_t offset;              // byte offset of the node's data from the start of the file
+    uint64_t first_point;         // index of the node's first point in node order
+    uint32_t num_points;
+    uint32_t subtree_nodes;       // this node and all of its descendants
+    int32_t children[8];          // node indices (-1 if empty)
+    float bbox_min[3];            // bounds of the whole subtree
+    float bbox_max[3];
+    float max_size;               // largest point size in the node
+    uint32_t reserved;
+} PcdOctreeNode;
+
+static_assert(sizeof(PcdOctreeHeader) == 304, "PcdOctreeHeader must match the on-disk layout");
+static_assert(sizeof(PcdOctreeNode) == 88, "PcdOctreeNode must match the on-disk layout");
+
+#endif // PCD_FILE_H
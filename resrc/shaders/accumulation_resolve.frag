@@ -0,0 +1,13 @@
+#version 150 core
+
+uniform sampler2D image;          // accumulated color
+uniform sampler2D depth_buffer;   // accumulated depth
+
+out vec4 FragColor;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    FragColor = texelFetch(image, pixel, 0);
+    gl_FragDepth = texelFetch(depth_buffer, pixel, 0).r;
+}
@@ -0,0 +1,8 @@
+#version 150 core
+
+out vec4 FragColor;
+
+void main() {
+    // only samples passed matter (color writes are masked off)
+    FragColor = vec4(1.0, 1.0, 1.0, 1.0);
+}
@@ -2,20 +2,30 @@
 
 in vec3 vertex_position;
 in vec3 vertex_normal;
+in uint vertex_material;   // index into the bound page of materials
 
-uniform mat4 model_matrix;
-uniform mat3 normal_matrix;
-uniform mat4 view_matrix;
-uniform mat4 projection_matrix;
+// per-frame camera and transforms (shared by all lit programs)
+layout(std140) uniform Transforms {
+    mat4 projection_matrix;
+    mat4 view_matrix;
+    mat4 model_matrix;
+    mat3 normal_matrix;
+    vec3 camera_position;
+};
 
 out vec3 world_position;
 out vec3 world_normal;
+flat out uint material_index;
+
+// depth pre-pass relies on identical positions (see depth.vert)
+invariant gl_Position;
 
 void main() {
     vec4 position = model_matrix * vec4(vertex_position, 1.0);
 
     world_position = position.xyz;
     world_normal = normalize(normal_matrix * vertex_normal);
+    material_index = vertex_material;
 
     gl_Position = projection_matrix * view_matrix * position;
 }
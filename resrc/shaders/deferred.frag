@@ -0,0 +1,129 @@
+#version 150 core
+
+in vec2 world_texcoord;
+
+uniform sampler2D image;                // composited G-buffer
+uniform sampler2D depth_buffer;         // composited depth
+uniform samplerBuffer material_table;   // two texels per material: color, specular + shininess
+uniform mat4 inverse_view_projection;
+uniform vec2 depth_to_ndc;             // NDC z = depth * x + y (composited depth convention)
+uniform vec3 camera_position;
+uniform vec4 background_color;
+
+layout(std140) uniform Lights {
+    // ambient light
+    vec3 light_ambient;
+    // point lights (up to 16)
+    int num_lights;
+    vec3 light_position[16];
+    vec3 light_color[16];
+    vec2 light_attenuation[16];
+    // spotlights (up to 8)
+    int num_spotlights;
+    vec3 spotlight_position[8];
+    vec3 spotlight_direction[8];
+    vec3 spotlight_color[8];
+    vec2 spotlight_attenuation[8];
+    vec2 spotlight_cos_fov[8];    // cos of cone edge (x) and inner cone (y)
+};
+// light counts fixed at compile time in specialized variants
+#ifndef NUM_LIGHTS
+#define NUM_LIGHTS num_lights
+#endif
+#ifndef NUM_SPOTLIGHTS
+#define NUM_SPOTLIGHTS num_spotlights
+#endif
+out vec4 FragColor;
+
+// inverse of the octahedral mapping in gbuffer.frag
+vec3 octahedralDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main() {
+    ivec2 pixel = ivec2(world_texcoord * vec2(textureSize(depth_buffer, 0)));
+    float depth = texelFetch(depth_buffer, pixel, 0).r;
+    if (depth >= 1.0) {
+        FragColor = background_color;
+        return;
+    }
+    vec4 gbuffer = texelFetch(image, pixel, 0);
+
+    // world position from composited depth
+    vec4 ndc = vec4(world_texcoord * 2.0 - 1.0, depth * depth_to_ndc.x + depth_to_ndc.y, 1.0);
+    vec4 position = inverse_view_projection * ndc;
+    vec3 world_position = position.xyz / position.w;
+    vec3 world_normal = octahedralDecode(gbuffer.rg * 2.0 - 1.0);
+
+    int material_id = int(gbuffer.b * 255.0 + 0.5) * 256 + int(gbuffer.a * 255.0 + 0.5);
+    vec3 material_color = texelFetch(material_table, 2 * material_id).rgb;
+    vec4 specular = texelFetch(material_table, 2 * material_id + 1);
+    vec3 material_specular = specular.rgb;
+    float material_shininess = specular.a;
+
+    vec3 light_diffuse = vec3(0.0, 0.0, 0.0);
+    vec3 light_specular = vec3(0.0, 0.0, 0.0);
+
+    int i;
+    
+    // point light illumination
+    for(i = 0; i < NUM_LIGHTS; i++) {
+        float full_light_dist = light_attenuation[i].x;
+        float no_light_dist = light_attenuation[i].y;
+        float attenuation_k = 1.0 / (full_light_dist * full_light_dist);
+        vec3 light_vector = light_position[i] - world_position;
+        float dist = length(light_vector);
+        if (dist < no_light_dist) {
+            //diffuse
+            vec3 light_direction = normalize(light_vector);
+            float light_attenuation = 1.0 / max(attenuation_k * dist * dist, 1.0);
+            float n_dot_l = max(dot(world_normal, light_direction), 0.0);
+            light_diffuse += light_color[i] * light_attenuation * n_dot_l;
+
+            //specular
+            vec3 reflection_direction = normalize(reflect(-light_direction, world_normal));
+            vec3 view_direction = normalize(camera_position - world_position);
+            float r_dot_v = max(dot(reflection_direction, view_direction), 0.0);
+            light_specular += light_color[i] * light_attenuation * pow(r_dot_v, material_shininess);
+        }
+    }
+
+    // spotlight illumination
+    for(i = 0; i < NUM_SPOTLIGHTS; i++) {
+        float full_spotlight_dist = spotlight_attenuation[i].x;
+        float no_spotlight_dist = spotlight_attenuation[i].y;
+        float attenuation_sk = 1.0 / (full_spotlight_dist * full_spotlight_dist);
+        vec3 light_vector = spotlight_position[i] - world_position;
+        float dist = length(light_vector);
+        if (dist < no_spotlight_dist) {
+            vec3 light_direction = normalize(light_vector);
+            float cos_angle = dot(-light_direction, spotlight_direction[i]);
+            if (cos_angle >= spotlight_cos_fov[i].x) {
+                float light_attenuation = 1.0 / max(attenuation_sk * dist * dist, 1.0);
+                float edge_attenuation = clamp((cos_angle - spotlight_cos_fov[i].x) /
+                                               (spotlight_cos_fov[i].y - spotlight_cos_fov[i].x), 0.0, 1.0);
+                light_attenuation *= edge_attenuation;
+
+                //diffuse
+                float n_dot_l = max(dot(world_normal, light_direction), 0.0);
+                light_diffuse += spotlight_color[i] * light_attenuation * n_dot_l;
+                //specular
+                vec3 reflection_direction = normalize(reflect(-light_direction, world_normal));
+                vec3 view_direction = normalize(camera_position - world_position);
+                float r_dot_v = max(dot(reflection_direction, view_direction), 0.0);
+                light_specular += spotlight_color[i] * light_attenuation * pow(r_dot_v, material_shininess);
+            }
+        }
+    }
+
+    light_diffuse = min(light_diffuse, 1.0);
+    light_specular = min(light_specular, 1.0);
+
+    vec3 final_color = min((light_ambient * material_color) + (light_diffuse * material_color) +
+                           (light_specular * material_specular), 1.0);
+
+    FragColor = vec4(final_color, 1.0);
+}
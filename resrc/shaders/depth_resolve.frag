@@ -0,0 +1,14 @@
+#version 150 core
+
+uniform sampler2D image;          // reverse-Z render color
+uniform sampler2D depth_buffer;   // reverse-Z render depth (near = 1)
+
+out vec4 FragColor;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    // IceT composites with near = 0 (depth buffer range, so far depths lose reverse-Z precision here)
+    FragColor = texelFetch(image, pixel, 0);
+    gl_FragDepth = 1.0 - texelFetch(depth_buffer, pixel, 0).r;
+}
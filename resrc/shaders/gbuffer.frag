@@ -0,0 +1,26 @@
+#version 150 core
+
+in vec3 world_normal;
+flat in uint material_index;
+
+// global ID of the first material in the bound page
+uniform uint material_base;
+
+out vec4 FragColor;
+
+// unit normal to [-1, 1]^2 (octahedral mapping)
+vec2 octahedralEncode(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if (n.z < 0.0) {
+        return (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return n.xy;
+}
+
+void main() {
+    // normal in RG, 16-bit material ID in BA (composited as an ordinary RGBA8 image)
+    vec2 normal = octahedralEncode(normalize(world_normal)) * 0.5 + 0.5;
+    uint material_id = material_base + material_index;
+
+    FragColor = vec4(normal, float(material_id >> 8u) / 255.0, float(material_id & 255u) / 255.0);
+}
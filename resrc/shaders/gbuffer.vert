@@ -0,0 +1,28 @@
+#version 150 core
+
+in vec3 vertex_position;
+in vec3 vertex_normal;
+in uint vertex_material;   // index into the page of materials
+
+layout(std140) uniform Transforms {
+    mat4 projection_matrix;
+    mat4 view_matrix;
+    mat4 model_matrix;
+    mat3 normal_matrix;
+    vec3 camera_position;
+};
+
+out vec3 world_normal;
+flat out uint material_index;
+
+// depth pre-pass relies on identical positions (see depth.vert)
+invariant gl_Position;
+
+void main() {
+    vec4 position = model_matrix * vec4(vertex_position, 1.0);
+
+    world_normal = normal_matrix * vertex_normal;
+    material_index = vertex_material;
+
+    gl_Position = projection_matrix * view_matrix * position;
+}
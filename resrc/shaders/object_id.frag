@@ -0,0 +1,12 @@
+#version 150 core
+
+// rank (high 8 bits) and group + 1 (low 24 bits), 0 is background
+uniform uint object_id;
+
+out vec4 FragColor;
+
+void main() {
+    // one byte per channel so the ID survives RGBA8 compositing exactly
+    FragColor = vec4(float(object_id >> 24u), float((object_id >> 16u) & 255u),
+                     float((object_id >> 8u) & 255u), float(object_id & 255u)) / 255.0;
+}
@@ -0,0 +1,17 @@
+#version 150 core
+
+in vec3 vertex_position;
+
+layout(std140) uniform Transforms {
+    mat4 projection_matrix;
+    mat4 view_matrix;
+    mat4 model_matrix;
+    mat3 normal_matrix;
+    vec3 camera_position;
+};
+
+void main() {
+    vec4 position = model_matrix * vec4(vertex_position, 1.0);
+
+    gl_Position = projection_matrix * view_matrix * position;
+}
@@ -1,4 +1,7 @@
 #version 330
+#ifdef CONSERVATIVE_DEPTH
+#extension GL_ARB_conservative_depth : require
+#endif
 
 in vec3 world_position;
 in mat3 world_normal_mat;
@@ -13,12 +16,25 @@ uniform vec3 light_ambient;
 uniform vec3 light_position[10];
 uniform vec3 light_color[10];
 uniform vec3 camera_position;
+#ifdef CONSERVATIVE_DEPTH
+uniform mat4 projection_matrix;
+uniform mat4 view_matrix;
+
+// impostor sits at the sphere's front, so the surface is never nearer and early depth tests
+// (GL_LESS) remain valid
+layout(depth_greater) out float gl_FragDepth;
+#endif
 
 out vec4 FragColor;
 
 void main() {
     // BILLBOARD SPHERES
+#ifdef POINT_SPRITES
+    // point sprite coordinates have y pointing down
+    vec2 norm_texcoord = vec2((2.0 * gl_PointCoord.x) - 1.0, 1.0 - (2.0 * gl_PointCoord.y));
+#else
     vec2 norm_texcoord = (2.0 * model_texcoord) - vec2(1.0, 1.0);
+#endif
     float magnitude = dot(norm_texcoord, norm_texcoord);
     if (magnitude > 1.0) {
         discard;
@@ -44,8 +60,13 @@ void main() {
     FragColor = vec4(final_color, 1.0);
 
     // Depth
+#if defined(CONSERVATIVE_DEPTH)
+    vec4 clip_position = projection_matrix * view_matrix * vec4(sphere_position, 1.0);
+    gl_FragDepth = max(0.5 * (clip_position.z / clip_position.w) + 0.5, gl_FragCoord.z);
+#elif !defined(FLAT_DEPTH)
     float near = clip_z.x;
     float far = clip_z.y;
     float dist = length(sphere_position - camera_position);
     gl_FragDepth = (dist - near) / (far - near);
+#endif
 }
@@ -12,6 +12,13 @@ uniform vec3 camera_position;
 uniform mat4 projection_matrix;
 uniform mat4 view_matrix;
 uniform mat4 model_matrix;
+#ifdef POINT_SPRITES
+uniform float viewport_height;
+#endif
+#ifdef QUANTIZED
+uniform vec3 chunk_min;
+uniform vec3 chunk_extent;
+#endif
 
 out vec3 world_position;
 out mat3 world_normal_mat;
@@ -21,7 +28,13 @@ out vec3 model_center;
 out float model_size;
 
 void main() {
-    vec3 world_point = (model_matrix * vec4(point_center, 1.0)).xyz;
+#ifdef QUANTIZED
+    // point_center is normalized within the chunk's bounds
+    vec3 center = chunk_min + chunk_extent * point_center;
+#else
+    vec3 center = point_center;
+#endif
+    vec3 world_point = (model_matrix * vec4(center, 1.0)).xyz;
     vec3 vertex_direction = normalize(world_point - camera_position);
 
     vec3 up = vec3(0.0, 1.0, 0.0);
@@ -29,8 +42,18 @@ void main() {
     vec3 cam_right = (length(right) > EPSILON) ? normalize(right) : vec3(0.0, 0.0, 1.0);
     vec3 cam_up = cross(cam_right, vertex_direction);
 
+#ifdef POINT_SPRITES
+    // one vertex per point, rasterized as a screen-aligned square of the projected diameter
+    world_position = world_point;
+#else
     world_position = world_point + cam_right * vertex_position.x * point_size +
                                          cam_up * vertex_position.y * point_size;
+#endif
+#if defined(FLAT_DEPTH) || defined(CONSERVATIVE_DEPTH)
+    // move the impostor to the sphere's front (flat: fixed-function depth is used as is,
+    // conservative: the sphere's depth is never less than the impostor's)
+    world_position -= vertex_direction * 0.5 * point_size;
+#endif
 
     vec3 n = -vertex_direction;
     vec3 u = normalize(cross(up, n));
@@ -43,4 +66,7 @@ void main() {
     model_size = point_size;
 
     gl_Position = projection_matrix * view_matrix * vec4(world_position, 1.0);
+#ifdef POINT_SPRITES
+    gl_PointSize = point_size * projection_matrix[1][1] * 0.5 * viewport_height / gl_Position.w;
+#endif
 }
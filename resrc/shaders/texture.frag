@@ -3,39 +3,66 @@
 in vec3 world_position;
 in vec3 world_normal;
 in vec2 world_texcoord;
+flat in uint material_index;
 
-// camera
-uniform vec3 camera_position;
-// ambient light
-uniform vec3 light_ambient;
-// point lights (up to 16)
-uniform int num_lights;
-uniform vec3 light_position[16];
-uniform vec3 light_color[16];
-uniform vec2 light_attenuation[16];
-// spotlights (up to 8)
-uniform int num_spotlights;
-uniform vec3 spotlight_position[8];
-uniform vec3 spotlight_direction[8];
-uniform vec3 spotlight_color[8];
-uniform vec2 spotlight_attenuation[8];
-uniform float spotlight_fov[8];
-// object material properties
-uniform vec3 material_color;      // Ka and Kd
-uniform vec3 material_specular;   // Ks
-uniform float material_shininess; // n
-uniform sampler2D image;
+#define MAX_MATERIALS 512
+
+struct Material {
+    vec4 color;                   // Ka and Kd (rgb) and texture layer (a)
+    vec4 specular;                // Ks (rgb) and n (a)
+};
+
+// camera and transforms
+layout(std140) uniform Transforms {
+    mat4 projection_matrix;
+    mat4 view_matrix;
+    mat4 model_matrix;
+    mat3 normal_matrix;
+    vec3 camera_position;
+};
+layout(std140) uniform Lights {
+    // ambient light
+    vec3 light_ambient;
+    // point lights (up to 16)
+    int num_lights;
+    vec3 light_position[16];
+    vec3 light_color[16];
+    vec2 light_attenuation[16];
+    // spotlights (up to 8)
+    int num_spotlights;
+    vec3 spotlight_position[8];
+    vec3 spotlight_direction[8];
+    vec3 spotlight_color[8];
+    vec2 spotlight_attenuation[8];
+    vec2 spotlight_cos_fov[8];    // cos of cone edge (x) and inner cone (y)
+};
+// light counts fixed at compile time in specialized variants
+#ifndef NUM_LIGHTS
+#define NUM_LIGHTS num_lights
+#endif
+#ifndef NUM_SPOTLIGHTS
+#define NUM_SPOTLIGHTS num_spotlights
+#endif
+// object material properties (indexed per draw)
+layout(std140) uniform Materials {
+    Material materials[MAX_MATERIALS];
+};
+uniform sampler2DArray image;
 
 out vec4 FragColor;
 
 void main() {
+    vec3 material_color = materials[material_index].color.rgb;
+    vec3 material_specular = materials[material_index].specular.rgb;
+    float material_shininess = materials[material_index].specular.a;
+
     vec3 light_diffuse = vec3(0.0, 0.0, 0.0);
     vec3 light_specular = vec3(0.0, 0.0, 0.0);
 
     int i;
     
     // point light illumination
-    for(i = 0; i < num_lights; i++) {
+    for(i = 0; i < NUM_LIGHTS; i++) {
         float full_light_dist = light_attenuation[i].x;
         float no_light_dist = light_attenuation[i].y;
         float attenuation_k = 1.0 / (full_light_dist * full_light_dist);
@@ -57,7 +84,7 @@ void main() {
     }
 
     // spotlight illumination
-    for(i = 0; i < num_spotlights; i++) {
+    for(i = 0; i < NUM_SPOTLIGHTS; i++) {
         float full_spotlight_dist = spotlight_attenuation[i].x;
         float no_spotlight_dist = spotlight_attenuation[i].y;
         float attenuation_sk = 1.0 / (full_spotlight_dist * full_spotlight_dist);
@@ -65,10 +92,11 @@ void main() {
         float dist = length(light_vector);
         if (dist < no_spotlight_dist) {
             vec3 light_direction = normalize(light_vector);
-            float angle = abs(acos(dot(-light_direction, normalize(spotlight_direction[i]))));
-            if (angle <= spotlight_fov[i]) {
+            float cos_angle = dot(-light_direction, spotlight_direction[i]);
+            if (cos_angle >= spotlight_cos_fov[i].x) {
                 float light_attenuation = 1.0 / max(attenuation_sk * dist * dist, 1.0);
-                float edge_attenuation = min(10.0 * (spotlight_fov[i] - angle) / spotlight_fov[i], 1.0);
+                float edge_attenuation = clamp((cos_angle - spotlight_cos_fov[i].x) /
+                                               (spotlight_cos_fov[i].y - spotlight_cos_fov[i].x), 0.0, 1.0);
                 light_attenuation *= edge_attenuation;
 
                 //diffuse
@@ -86,7 +114,7 @@ void main() {
     light_diffuse = min(light_diffuse, 1.0);
     light_specular = min(light_specular, 1.0);
     
-    vec4 tex_color = texture(image, world_texcoord);
+    vec4 tex_color = texture(image, vec3(world_texcoord, materials[material_index].color.a));
     vec3 material_tex = ((1.0 - tex_color.a) * material_color) + (tex_color.a * tex_color.rgb);
 
     vec3 final_color = min((light_ambient * material_tex) + (light_diffuse * material_tex) +
@@ -1,8 +1,10 @@
 #include <iostream>
 #include <cmath>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <map>
+#include <algorithm>
 #include <glad/glad.h>
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
@@ -24,12 +26,137 @@
 
 #define WINDOW_TITLE "Neurons (IceT)"
 
+// ARB_clip_control (GL 4.5 core, not part of the GL 3.2 loader)
+#ifndef GL_ZERO_TO_ONE
+#define GL_ZERO_TO_ONE 0x935F
+#endif
+#ifndef GL_NEGATIVE_ONE_TO_ONE
+#define GL_NEGATIVE_ONE_TO_ONE 0x935E
+#endif
+typedef void (APIENTRY *ClipControlProc)(GLenum origin, GLenum depth);
+
+// Uniform block binding points (see resrc/shaders)
+#define TRANSFORM_BLOCK_BINDING 0
+#define LIGHT_BLOCK_BINDING 1
+#define MATERIAL_BLOCK_BINDING 2
+#define MAX_MATERIALS 512             // materials per bound page of the material UBO
+#define OCCLUSION_VISIBLE_INTERVAL 4  // frames between queries of a visible leaf
+#define OCCLUSION_DEPTH_SCALE 8       // composited depth is shared at 1/8 resolution (per axis)
+#define OCCLUSION_HIDDEN_RESULTS 2    // consecutive hidden results before a visible node is culled
+#define OCCLUSION_CHECK_FRAMES 30     // untimed frames compared against an unculled render
+
+// Issue a GL call from the frame's render path and count it (reported as GL calls per frame)
+#define COUNT_GL(call) (app.gl_call_count += 1.0, call)
+
+
+typedef struct UniformLocations {
+    // Transforms (composite and text programs)
+    GLint projection_matrix;
+    GLint modelview_matrix;
+    // Textures and text
+    GLint image;
+    GLint font_color;
+    // Deferred shading (G-buffer and lighting programs)
+    GLint material_base;
+    GLint depth_buffer;
+    GLint material_table;
+    GLint inverse_view_projection;
+    GLint depth_to_ndc;
+    GLint camera_position;
+    GLint background_color;
+    // Object ID pass
+    GLint object_id;
+    // Occlusion query proxies
+    GLint bbox_min;
+    GLint bbox_max;
+} UniformLocations;
 
 typedef struct GlslProgram {
     GLuint program;
     std::map<std::string,GLint> uniforms;
+    UniformLocations loc;         // resolved once at load time (-1 if unused)
 } GlslProgram;
 
+// std140 layouts of the Transforms, Lights and Materials uniform blocks
+typedef struct TransformBlock {
+    float projection_matrix[16];
+    float view_matrix[16];
+    float model_matrix[16];
+    float normal_matrix[12];      // mat3 stored as three vec4 columns
+    float camera_position[4];
+} TransformBlock;
+
+typedef struct LightBlock {
+    float light_ambient[3];
+    GLint num_lights;
+    float light_position[16][4];
+    float light_color[16][4];
+    float light_attenuation[16][4];
+    GLint num_spotlights;
+    GLint padding[3];
+    float spotlight_position[8][4];
+    float spotlight_direction[8][4];  // normalized on the CPU
+    float spotlight_color[8][4];
+    float spotlight_attenuation[8][4];
+    float spotlight_cos_fov[8][4];    // cosines of the cone edge and of the full-intensity inner cone
+} LightBlock;
+
+typedef struct MaterialEntry {
+    float color[4];               // layer in the draw's texture array stored in w (-1 if untextured)
+    float specular[4];            // shininess stored in w
+} MaterialEntry;
+
+typedef struct TextureArray {
+    GLuint texture;
+    GLint width;                  // size shared by every layer
+    GLint height;
+    std::vector<GLuint> sources;  // material texture copied into each layer
+} TextureArray;
+
+typedef struct DrawItem {
+    GlslProgram *program;
+    GLuint texture;               // 0 if untextured
+    GLuint material_index;        // into material_table (and material UBO)
+    const Model *model;
+    GLuint face_index_count;
+    int batch;                    // into draw_batches
+    GLint base_vertex;            // offset of this group in the batch buffers
+    GLuint first_index;
+    bool visible;
+    bool occluded;                // culled by occlusion queries
+} DrawItem;
+
+typedef struct DrawBatch {
+    GlslProgram *program;
+    GLuint texture;
+    GLint material_page;
+    GLuint vertex_array;
+    GLuint buffers[5];            // position, normal, texcoord, material index, element
+    // Visible draws, rebuilt with the render queue
+    std::vector<GLsizei> counts;
+    std::vector<const GLvoid*> index_offsets;
+    std::vector<GLint> base_vertices;
+} DrawBatch;
+
+typedef struct OcclusionNode {
+    glm::vec3 bbox_min;           // object space (transformed by the model matrix like the groups)
+    glm::vec3 bbox_max;
+    int children[2];              // -1 for leaves
+    int parent;
+    int item;                     // draw_list index of a leaf (-1 for inner nodes)
+    GLuint query;
+    bool query_pending;
+    bool visible;
+    int hidden_results;           // consecutive zero-sample results while visible
+} OcclusionNode;
+
+typedef struct BoundState {
+    GlslProgram *program;
+    GLuint texture;
+    GLint material_page;
+    GLuint vertex_array;
+} BoundState;
+
 typedef struct AppData {
     // MPI info
     int rank;
@@ -42,6 +169,13 @@ typedef struct AppData {
     IceTCommunicator comm;
     IceTContext context;
     IceTImage image;
+    // Sort-first tiling (replicated data, one display tile per rank)
+    bool sort_first;
+    std::vector<IceTInt> tile_viewports;
+    int render_width;
+    int render_height;
+    std::vector<IceTUByte> frame_pixels;
+    double tile_gather_time;
     // FPS counter
     double frame_time_start;
     int num_frames;
@@ -53,12 +187,84 @@ typedef struct AppData {
     // Model info
     std::vector<ObjLoader*> model_list;
     GLuint plane_vertex_array;
+    // Render queue (sorted by program, texture, then material)
+    std::vector<DrawItem> draw_list;
+    std::vector<DrawItem*> render_queue;
+    bool render_queue_dirty;
+    bool state_sort;
+    std::vector<DrawBatch> draw_batches;
+    bool multi_draw;
+    double gl_call_count;
+    double submit_time;
+    double lookup_time_map;       // start-up submission benchmark (string keys vs resolved handles)
+    double lookup_time_resolved;
+    double icet_render_time;
+    bool shader_variants;
+    bool depth_prepass;
+    // Deferred shading (ranks composite normal + material ID, display rank shades)
+    bool deferred;
+    GLuint material_id_offset;    // global ID of this rank's first material
+    GLuint deferred_material_buffer;
+    GLuint deferred_material_texture;
+    GLuint composite_depth_texture;
+    // Visibility feedback (composited object IDs select the groups drawn until the next refresh)
+    int visibility_refresh;       // frames between object ID passes (0 disables)
+    bool id_pass;
+    int visibility_updates;
+    double visible_groups;
+    double visibility_time;
+    // Hierarchical occlusion culling (bounding box queries, results used when available)
+    bool occlusion_culling;
+    std::vector<OcclusionNode> occlusion_nodes;  // root is node 0
+    GLuint box_vertex_array;
+    // Previous frame's composited depth (farthest per block), so occluders on other ranks cull too
+    GLuint occlusion_framebuffer;  // 0 if queries test the rank's own depth (sort-first)
+    GLuint occlusion_depth_texture;
+    int occlusion_depth_width;
+    int occlusion_depth_height;
+    std::vector<float> occlusion_depth;
+    double occluded_groups;
+    double occlusion_queries;
+    double occlusion_differing_pixels;  // average over the check frames (rank 0)
+    int occlusion_max_differing_pixels;
+    // Reverse-Z (near at depth 1, far at 0) into a float depth buffer, mapped to IceT's convention
+    // (see compositedToRenderDepth)
+    bool reverse_z;
+    ClipControlProc clip_control; // NULL if unsupported ([-1, 1] clip range kept)
+    glm::dmat4 reverse_z_matrix;  // applied after the (IceT) projection
+    double near_plane;
+    double far_plane;
+    GLuint resolve_vertex_array;
+    GLuint fragment_queries[2];   // GL_SAMPLES_PASSED of the lit pass, read back one frame late
+    int fragment_query_frame;
+    double fragments_shaded;
+    // Uniform buffers shared by the lit programs
+    GLuint transform_ubo;
+    GLuint light_ubo;
+    GLuint material_ubo;
+    std::vector<MaterialEntry> material_table;
+    std::vector<glm::vec4> material_averages;  // texture average of each material_table entry
+    std::map<std::string, GLuint> material_lookup;  // entry and texture average bytes -> material_table index
+    // Material textures copied into the layers of one texture array per texture size
+    std::vector<TextureArray> texture_arrays;
     // Rendering info
     bool color_by_rank;
     std::map<std::string, GlslProgram> glsl_program;
+    GlslProgram *color_program;
+    GlslProgram *texture_program;
+    GlslProgram *nolight_program;
+    GlslProgram *text_program;
+    GlslProgram *depth_program;
+    GlslProgram *gbuffer_program;
+    GlslProgram *deferred_program;
+    GlslProgram *object_id_program;
+    GlslProgram *bbox_program;
+    GlslProgram *depth_resolve_program;
     glm::vec4 background_color;
     glm::vec3 camera_position;
+    glm::dvec3 rotation_center;   // model rotates about the y axis through this point
     glm::dmat4 projection_matrix;
+    glm::dmat4 render_projection_matrix;
     glm::dmat4 view_matrix;
     glm::dmat4 model_matrix;
     glm::dmat3 normal_matrix;
@@ -72,11 +278,12 @@ typedef struct AppData {
     GLuint vertex_position_attrib;
     GLuint vertex_normal_attrib;
     GLuint vertex_texcoord_attrib;
+    GLuint vertex_material_attrib;
     GLuint composite_texture;
     TR_FontFace *font;
-    GLuint framebuffer;           // only used in IceT generic compositing
-    GLuint framebuffer_texture;   // only used in IceT generic compositing
-    GLuint framebuffer_depth;     // only used in IceT generic compositing
+    GLuint framebuffer;           // only used in IceT generic compositing (or OGL3 with reverse-Z)
+    GLuint framebuffer_texture;   // only used in IceT generic compositing (or OGL3 with reverse-Z)
+    GLuint framebuffer_depth;     // only used in IceT generic compositing (or OGL3 with reverse-Z)
     // Output to PPM image
     std::string outfile;
 } AppData;
@@ -104,18 +311,82 @@ const float RANK_COLORS[16][3] = {
 void parseCommandLineArgs(int argc, char **argv);
 void init();
 void doFrame();
+void compositeFrame();
+void rotateModel();
 void renderIceTOGL3(const IceTDouble *projection_matrix, const IceTDouble *modelview_matrix,
                     const IceTInt *readback_viewport, IceTUInt framebuffer_id);
 void renderIceTGeneric(const IceTDouble *projection_matrix, const IceTDouble *modelview_matrix,
                        const IceTFloat *background_color, const IceTInt *readback_viewport,
                        IceTImage result);
 void render();
+void setReverseZ(bool enable);
+void resolveReverseZ();
+void fitDepthRange(const float bbox[6]);
+float compositedToRenderDepth(float depth);
+void createRenderFramebuffer();
 void display();
+void computeTileLayout();
+void gatherTiles();
+void createDrawList();
+GLint textureArrayLayer(const Material& mat, GLuint *texture);
+void createTextureArrays();
+void createDrawBatches();
+void buildRenderQueue();
+void benchmarkFrameSubmission();
+void drawRenderQueue(GlslProgram *override_program);
+void bindBatch(const DrawBatch *batch, BoundState *bound, bool skip_redundant, GlslProgram *override_program);
+bool drawItemLess(const DrawItem *a, const DrawItem *b);
+GLuint addMaterial(const MaterialEntry& entry, glm::vec4 texture_average);
+void createUniformBuffers();
+void createDeferredMaterials();
+void drawDeferredLighting(const float mat4_projection[16], const float mat4_modelview[16]);
+void updateVisibility();
+void createOcclusionHierarchy();
+void createOcclusionDepth();
+void shareOcclusionDepth();
+int buildOcclusionNode(std::vector<int>& items, int begin, int end, int parent);
+void updateOcclusionResults();
+void checkOcclusionCulling();
+void setOcclusionSubtreeVisible(int node, bool visible);
+int issueOcclusionQueries(int node, const glm::vec3& camera);
+void drawObjectIds();
+void copyBuffer(GLuint src, GLuint dst, GLintptr dst_offset, GLsizeiptr size);
 void mat4ToFloatArray(glm::dmat4 mat4, float array[16]);
-void mat3ToFloatArray(glm::dmat3 mat3, float array[9]);
-void loadShader(std::string key, std::string shader_filename_base);
+void mat3ToStd140Array(glm::dmat3 mat3, float array[12]);
+void addPointLight(LightBlock *lights, glm::vec3 position, glm::vec3 color, glm::vec2 attenuation);
+void addSpotlight(LightBlock *lights, glm::vec3 position, glm::vec3 direction, glm::vec3 color,
+                  glm::vec2 attenuation, float fov);
+void addPointLight(LightBlock *lights, glm::vec3 position, glm::vec3 color, glm::vec2 attenuation)
+{
+    int i = lights->num_lights;
+    memcpy(lights->light_position[i], glm::value_ptr(position), 3 * sizeof(float));
+    memcpy(lights->light_color[i], glm::value_ptr(color), 3 * sizeof(float));
+    memcpy(lights->light_attenuation[i], glm::value_ptr(attenuation), 2 * sizeof(float));
+    lights->num_lights++;
+}
+
+void addSpotlight(LightBlock *lights, glm::vec3 position, glm::vec3 direction, glm::vec3 color,
+                  glm::vec2 attenuation, float fov)
+{
+    // Direction and cone cosines are computed once here instead of per fragment
+    int i = lights->num_spotlights;
+    glm::vec3 unit_direction = glm::normalize(direction);
+    memcpy(lights->spotlight_position[i], glm::value_ptr(position), 3 * sizeof(float));
+    memcpy(lights->spotlight_direction[i], glm::value_ptr(unit_direction), 3 * sizeof(float));
+    memcpy(lights->spotlight_color[i], glm::value_ptr(color), 3 * sizeof(float));
+    memcpy(lights->spotlight_attenuation[i], glm::value_ptr(attenuation), 2 * sizeof(float));
+    lights->spotlight_cos_fov[i][0] = cos(fov);
+    lights->spotlight_cos_fov[i][1] = cos(0.9 * fov); // intensity falls off over the outer 10% of the cone
+    lights->num_spotlights++;
+}
+
+void loadShader(std::string key, std::string shader_filename_base, const char *defines = NULL);
+void resolveUniformLocations(GlslProgram *p);
+GLint findUniform(GlslProgram *p, const char *name);
+void bindUniformBlock(GLuint program, const char *name, GLuint binding);
 void loadObjModels(std::string model_path, float bbox[6]);
 GLuint planeVertexArray();
+GLuint boxVertexArray();
 void writePpm(const char *filename, int width, int height, const uint8_t *rgba);
 
 AppData app;
@@ -207,6 +478,35 @@ int main(int argc, char **argv)
     read_time = app.pixel_read_time;
     MPI_Reduce(&read_time, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
     read_time = collect / (double)app.num_proc;
+    double gl_calls = app.gl_call_count;
+    MPI_Reduce(&gl_calls, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    gl_calls = collect / (double)app.num_proc;
+    double submit_time = app.submit_time;
+    MPI_Reduce(&submit_time, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    submit_time = collect / (double)app.num_proc;
+    double icet_render_time = app.icet_render_time;
+    MPI_Reduce(&icet_render_time, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    icet_render_time = collect / (double)app.num_proc;
+    double fragments_shaded = app.fragments_shaded / std::max(app.fragment_query_frame - 1, 1);
+    MPI_Reduce(&fragments_shaded, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    fragments_shaded = collect / (double)app.num_proc;
+    double visible_groups = app.visible_groups / std::max(app.visibility_updates, 1);
+    MPI_Reduce(&visible_groups, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    visible_groups = collect;
+    int total_groups = app.draw_list.size();
+    int collect_groups;
+    MPI_Reduce(&total_groups, &collect_groups, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    total_groups = collect_groups;
+    double occluded_groups = app.occluded_groups;
+    MPI_Reduce(&occluded_groups, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    occluded_groups = collect;
+    double occlusion_queries = app.occlusion_queries;
+    MPI_Reduce(&occlusion_queries, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    occlusion_queries = collect;
+    if (app.occlusion_culling)
+    {
+        checkOcclusionCulling();
+    }
 
     if (app.rank == 0)
     {
@@ -223,15 +523,62 @@ int main(int argc, char **argv)
         const char *composite_method = "IceT Generic";
         const char *composite_method_short = "IceTGeneric";
 #endif
-        char statfile[64];
-        snprintf(statfile, 64, "Neurons_%s_%dx%d_%dproc.txt", composite_method_short,
-                 app.window_width, app.window_height, app.num_proc);
+        const char *render_mode = app.sort_first ? "Sort-First" : "Sort-Last";
+        const char *render_mode_short = app.sort_first ? "SortFirst" : "SortLast";
+        char statfile[128];
+        snprintf(statfile, 128, "Neurons_%s_%s_%dx%d_%dproc.txt", composite_method_short,
+                 render_mode_short, app.window_width, app.window_height, app.num_proc);
         FILE *fp = fopen(statfile, "w");
-        fprintf(fp, "Data Set, Image Width, Image Height, Composite Method, Number of Processes\n");
-        fprintf(fp, "Neurons, %d, %d, %s, %d\n\n", app.window_width, app.window_height,
-                composite_method, app.num_proc);
+        fprintf(fp, "Data Set, Image Width, Image Height, Composite Method, Number of Processes, Render Mode\n");
+        fprintf(fp, "Neurons, %d, %d, %s, %d, %s\n\n", app.window_width, app.window_height,
+                composite_method, app.num_proc, render_mode);
         fprintf(fp, "Average FPS, Average Compression Compute Time, Average Memory Transfer Time\n");
         fprintf(fp, "%.3lf, %.6lf, %.6lf\n\n", avg_fps, avg_compress_time, avg_read_time);
+        fprintf(fp, "State Sorted Draws, Average GL Calls per Frame\n");
+        fprintf(fp, "%s, %.1lf\n\n", app.state_sort ? "Yes" : "No", gl_calls / animation_frames);
+        fprintf(fp, "Shader Variants, Average Render Time\n");
+        fprintf(fp, "%s, %.6lf\n\n", app.shader_variants ? "Yes" : "No", icet_render_time / animation_frames);
+        fprintf(fp, "Depth Pre-Pass, Deferred Shading, Average Fragments Shaded per Frame\n");
+        fprintf(fp, "%s, %s, %.0lf\n\n", app.depth_prepass ? "Yes" : "No", app.deferred ? "Yes" : "No",
+                fragments_shaded);
+        fprintf(fp, "Average Render Submit Time, Submit Lookup Time per Frame (String Map), Submit Lookup Time per Frame (Resolved), Unique Materials\n");
+        fprintf(fp, "%.6lf, %.9lf, %.9lf, %d\n\n", submit_time / animation_frames, app.lookup_time_map,
+                app.lookup_time_resolved, (int)app.material_table.size());
+        fprintf(fp, "Multi-Draw Batching, Draw Batches, Draw Groups\n");
+        fprintf(fp, "%s, %d, %d\n\n", (app.multi_draw && app.state_sort) ? "Yes" : "No",
+                (int)app.draw_batches.size(), (int)app.draw_list.size());
+        fprintf(fp, "Visibility Refresh Interval, Average Visible Groups, Total Groups, Average Visibility Update Time\n");
+        fprintf(fp, "%d, %.1lf, %d, %.6lf\n\n", app.visibility_refresh, app.visibility_refresh > 0 ? visible_groups : total_groups,
+                total_groups, app.visibility_time / std::max(app.visibility_updates, 1));
+        fprintf(fp, "Occlusion Culling, Average Occluded Groups per Frame, Average Occlusion Queries per Frame, Average Pixels Differing from Unculled, Max Pixels Differing from Unculled\n");
+        if (app.occlusion_culling)
+        {
+            fprintf(fp, "Yes, %.1lf, %.1lf, %.1lf, %d\n\n", occluded_groups / animation_frames, occlusion_queries / animation_frames,
+                    app.occlusion_differing_pixels, app.occlusion_max_differing_pixels);
+        }
+        else
+        {
+            fprintf(fp, "No, %.1lf, %.1lf, N/A, N/A\n\n", occluded_groups / animation_frames, occlusion_queries / animation_frames);
+        }
+        fprintf(fp, "Reverse-Z Depth, Clip Control, Near Plane, Far Plane\n");
+        fprintf(fp, "%s, %s, %.4lf, %.4lf\n\n", app.reverse_z ? "Yes" : "No", app.clip_control != NULL ? "Yes" : "No",
+                app.near_plane, app.far_plane);
+        int i;
+        int texture_layers = 0;
+        double texture_mb = 0.0;
+        for (i = 0; i < app.texture_arrays.size(); i++)
+        {
+            const TextureArray& array = app.texture_arrays[i];
+            texture_layers += array.sources.size();
+            texture_mb += (4.0 / 3.0) * 4.0 * array.width * array.height * array.sources.size() / (1024.0 * 1024.0);
+        }
+        fprintf(fp, "Texture Arrays, Texture Array Layers, Texture Array Memory with Mipmaps (MB)\n");
+        fprintf(fp, "%d, %d, %.3lf\n\n", (int)app.texture_arrays.size(), texture_layers, texture_mb);
+        if (app.sort_first)
+        {
+            fprintf(fp, "Average Tile Gather Time\n");
+            fprintf(fp, "%.6lf\n\n", app.tile_gather_time / animation_frames);
+        }
         fclose(fp);
     }
 
@@ -253,6 +600,23 @@ void parseCommandLineArgs(int argc, char **argv)
     app.window_height = 720;
     app.show_fps = false;
     app.color_by_rank = false;
+    app.sort_first = false;
+    app.state_sort = true;
+    app.multi_draw = true;
+    app.shader_variants = true;
+    app.depth_prepass = false;
+    app.deferred = false;
+    app.visibility_refresh = 0;
+    app.id_pass = false;
+    app.visibility_updates = 0;
+    app.visible_groups = 0.0;
+    app.visibility_time = 0.0;
+    app.occlusion_culling = false;
+    app.occluded_groups = 0.0;
+    app.occlusion_queries = 0.0;
+    app.occlusion_framebuffer = 0;
+    app.reverse_z = false;
+    app.clip_control = NULL;
     app.outfile = "";
 
     // User options
@@ -280,6 +644,51 @@ void parseCommandLineArgs(int argc, char **argv)
             app.color_by_rank = true;
             i += 1;
         }
+        else if (argument == "--sort-first" || argument == "-s")
+        {
+            app.sort_first = true;
+            i += 1;
+        }
+        else if (argument == "--no-state-sort")
+        {
+            app.state_sort = false;
+            i += 1;
+        }
+        else if (argument == "--no-multi-draw")
+        {
+            app.multi_draw = false;
+            i += 1;
+        }
+        else if (argument == "--no-shader-variants")
+        {
+            app.shader_variants = false;
+            i += 1;
+        }
+        else if (argument == "--depth-prepass")
+        {
+            app.depth_prepass = true;
+            i += 1;
+        }
+        else if (argument == "--deferred")
+        {
+            app.deferred = true;
+            i += 1;
+        }
+        else if (argument == "--occlusion-culling")
+        {
+            app.occlusion_culling = true;
+            i += 1;
+        }
+        else if (argument == "--reverse-z")
+        {
+            app.reverse_z = true;
+            i += 1;
+        }
+        else if (argument == "--visibility-refresh" && i < argc - 1)
+        {
+            app.visibility_refresh = std::stoi(argv[i + 1]);
+            i += 2;
+        }
         else if ((argument == "--outfile" || argument == "-o") && i < argc - 1)
         {
             app.outfile = argv[i + 1];
@@ -290,6 +699,26 @@ void parseCommandLineArgs(int argc, char **argv)
             i += 1;
         }
     }
+
+    // Sort-first only gathers color tiles, so there is no composited depth to shade from
+    if (app.deferred && app.sort_first)
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Warning: deferred shading is not supported in sort-first mode (disabled)\n");
+        }
+        app.deferred = false;
+    }
+
+    // Object IDs hold the rank in 8 bits and only identify the owning rank's groups in sort-last
+    if (app.visibility_refresh > 0 && (app.sort_first || app.num_proc > 256))
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Warning: visibility feedback requires sort-last and at most 256 processes (disabled)\n");
+        }
+        app.visibility_refresh = 0;
+    }
 }
 
 void init()
@@ -303,43 +732,67 @@ void init()
 
     // Set IceT window configurations
     icetResetTiles();
-    icetAddTile(0, 0, app.window_width, app.window_height, 0);
+    if (app.sort_first)
+    {
+        // One tile per rank, every rank holds all of the data
+        computeTileLayout();
+        int i;
+        std::vector<IceTInt> replication_group(app.num_proc);
+        for (i = 0; i < app.num_proc; i++)
+        {
+            icetAddTile(app.tile_viewports[4 * i + 0], app.tile_viewports[4 * i + 1],
+                        app.tile_viewports[4 * i + 2], app.tile_viewports[4 * i + 3], i);
+            replication_group[i] = i;
+        }
+        icetDataReplicationGroup(app.num_proc, replication_group.data());
+
+        IceTInt tile_max_width, tile_max_height;
+        icetGetIntegerv(ICET_TILE_MAX_WIDTH, &tile_max_width);
+        icetGetIntegerv(ICET_TILE_MAX_HEIGHT, &tile_max_height);
+        app.render_width = tile_max_width;
+        app.render_height = tile_max_height;
+        if (app.rank == 0)
+        {
+            app.frame_pixels.resize(4 * app.window_width * app.window_height);
+        }
+    }
+    else
+    {
+        icetAddTile(0, 0, app.window_width, app.window_height, 0);
+        app.render_width = app.window_width;
+        app.render_height = app.window_height;
+    }
+    app.tile_gather_time = 0.0;
 
     // Set IceT compositing strategy
-    icetStrategy(ICET_STRATEGY_SEQUENTIAL); // best for a single tile
-    //icetStrategy(ICET_STRATEGY_REDUCE); // good all around performance for multiple tiles
+    if (app.sort_first)
+    {
+        icetStrategy(ICET_STRATEGY_REDUCE); // good all around performance for multiple tiles
+    }
+    else
+    {
+        icetStrategy(ICET_STRATEGY_SEQUENTIAL); // best for a single tile
+    }
 
     // Set IceT framebuffer settings
     icetSetColorFormat(ICET_IMAGE_COLOR_RGBA_UBYTE);
     icetSetDepthFormat(ICET_IMAGE_DEPTH_FLOAT);
+    if (app.deferred || (app.occlusion_culling && !app.sort_first))
+    {
+        // Keep composited depth so the display rank can reconstruct positions / share occluders
+        icetDisable(ICET_COMPOSITE_ONE_BUFFER);
+    }
 
     // Set IceT draw callback (main render function)
 #ifdef USE_ICET_OGL3
     icetGL3DrawCallbackTexture(renderIceTOGL3);
+    if (app.reverse_z)
+    {
+        // Rendered into a float depth buffer, then resolved into IceT's framebuffer
+        createRenderFramebuffer();
+    }
 #else
-    glGenTextures(1, &(app.framebuffer_texture));
-    glBindTexture(GL_TEXTURE_2D, app.framebuffer_texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, app.window_width, app.window_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    glGenTextures(1, &(app.framebuffer_depth));
-    glBindTexture(GL_TEXTURE_2D, app.framebuffer_depth);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, app.window_width, app.window_height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    glGenFramebuffers(1, &(app.framebuffer));
-    glBindFramebuffer(GL_FRAMEBUFFER, app.framebuffer);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, app.framebuffer_texture, 0);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, app.framebuffer_depth, 0);
-    GLenum draw_buffers[1] = {GL_COLOR_ATTACHMENT0};
-    glDrawBuffers(1, draw_buffers);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    createRenderFramebuffer();
 
     icetDrawCallback(renderIceTGeneric);
 #endif
@@ -414,10 +867,15 @@ void init()
     }
 
     // Create projection and view matrices
-    app.projection_matrix = glm::perspective(glm::radians(60.0), (double)app.window_width / (double)app.window_height, 0.1, 250.0);
+    app.near_plane = 0.1;
+    app.far_plane = 250.0;
+    app.projection_matrix = glm::perspective(glm::radians(60.0), (double)app.window_width / (double)app.window_height,
+                                             app.near_plane, app.far_plane);
+    app.render_projection_matrix = app.projection_matrix;
     app.camera_position = glm::vec3(40.0, 28.0, -100.0);
     app.view_matrix = glm::lookAt(app.camera_position, glm::vec3(40.0, 28.0, -20.0), glm::vec3(0.0, 1.0, 0.0));
     app.model_matrix = glm::dmat4(1.0);
+    app.rotation_center = glm::dvec3(40.0, 28.0, -20.0);
     app.composite_mv_matrix = glm::translate(glm::dmat4(1.0), glm::dvec3((double)app.window_width / 2.0, (double)app.window_height / 2.0, -0.5));
     app.composite_mv_matrix = glm::scale(app.composite_mv_matrix, glm::dvec3((double)app.window_width, (double)app.window_height, 1.0));
 
@@ -428,16 +886,81 @@ void init()
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glViewport(0, 0, app.window_width, app.window_height);
 
+    // Reverse-Z only gains float precision with a [0, 1] clip range
+    app.reverse_z_matrix = glm::dmat4(1.0);
+    if (app.reverse_z)
+    {
+        if (glfwExtensionSupported("GL_ARB_clip_control"))
+        {
+            app.clip_control = (ClipControlProc)glfwGetProcAddress("glClipControl");
+        }
+        if (app.clip_control != NULL)
+        {
+            // z' = (w - z) / 2 maps near to 1 and far to 0
+            app.reverse_z_matrix[2][2] = -0.5;
+            app.reverse_z_matrix[3][2] = 0.5;
+        }
+        else
+        {
+            if (app.rank == 0)
+            {
+                fprintf(stderr, "Warning: glClipControl not supported, reverse-Z keeps the [-1, 1] clip range\n");
+            }
+            app.reverse_z_matrix[2][2] = -1.0;
+        }
+        app.resolve_vertex_array = 0;
+        glGenVertexArrays(1, &(app.resolve_vertex_array));
+    }
+
     // Initialize vertex attributes
     app.vertex_position_attrib = 0;
     app.vertex_normal_attrib = 1;
     app.vertex_texcoord_attrib = 2;
+    app.vertex_material_attrib = 3;
+
+    // Lights
+    glm::vec3 ambient = glm::vec3(0.2, 0.2, 0.2);
+    glm::vec3 point_light_pos = glm::vec3(40.0, 28.0, -100.0);
+    glm::vec3 point_light_col = glm::vec3(1.0, 1.0, 1.0);
+    glm::vec2 point_light_atten = glm::vec2(50.0, 250.0);
 
-    // Load shader programs
-    loadShader("color", "resrc/shaders/color");
-    loadShader("texture", "resrc/shaders/texture");
+    LightBlock lights;
+    memset(&lights, 0, sizeof(LightBlock));
+    memcpy(lights.light_ambient, glm::value_ptr(ambient), 3 * sizeof(float));
+    addPointLight(&lights, point_light_pos, point_light_col, point_light_atten);
+
+    // Load shader programs (lit programs are specialized for the number of lights)
+    char light_defines[64] = "";
+    char light_key[32] = "";
+    if (app.shader_variants)
+    {
+        snprintf(light_defines, 64, "#define NUM_LIGHTS %d\n#define NUM_SPOTLIGHTS %d\n",
+                 lights.num_lights, lights.num_spotlights);
+        snprintf(light_key, 32, "_L%d_S%d", lights.num_lights, lights.num_spotlights);
+    }
+    std::string color_key = std::string("color") + light_key;
+    std::string texture_key = std::string("texture") + light_key;
+    loadShader(color_key, "resrc/shaders/color", light_defines);
+    loadShader(texture_key, "resrc/shaders/texture", light_defines);
     loadShader("nolight", "resrc/shaders/nolight_texture");
     loadShader("text", "resrc/shaders/text");
+    loadShader("depth", "resrc/shaders/depth");
+    loadShader("gbuffer", "resrc/shaders/gbuffer");
+    loadShader("object_id", "resrc/shaders/object_id");
+    loadShader("bbox", "resrc/shaders/bbox");
+    loadShader("depth_resolve", "resrc/shaders/depth_resolve");
+    std::string deferred_key = std::string("deferred") + light_key;
+    loadShader(deferred_key, "resrc/shaders/deferred", light_defines);
+    app.color_program = &(app.glsl_program[color_key]);
+    app.texture_program = &(app.glsl_program[texture_key]);
+    app.nolight_program = &(app.glsl_program["nolight"]);
+    app.text_program = &(app.glsl_program["text"]);
+    app.depth_program = &(app.glsl_program["depth"]);
+    app.gbuffer_program = &(app.glsl_program["gbuffer"]);
+    app.deferred_program = &(app.glsl_program[deferred_key]);
+    app.object_id_program = &(app.glsl_program["object_id"]);
+    app.bbox_program = &(app.glsl_program["bbox"]);
+    app.depth_resolve_program = &(app.glsl_program["depth_resolve"]);
 
     // Load nuclear station OBJ models
     float bbox[6];
@@ -446,6 +969,30 @@ void init()
 #ifdef USE_ICET_OGL3
     icetBoundingBoxf(bbox[0], bbox[1], bbox[2], bbox[3], bbox[4], bbox[5]);
 #endif
+    if (app.reverse_z)
+    {
+        fitDepthRange(bbox);
+    }
+
+    // Create list of draws and sort into render queue
+    createDrawList();
+    createUniformBuffers();
+    if (app.occlusion_culling)
+    {
+        createOcclusionHierarchy();
+        createOcclusionDepth();
+    }
+    if (app.deferred)
+    {
+        createDeferredMaterials();
+    }
+    app.gl_call_count = 0.0;
+    app.submit_time = 0.0;
+    benchmarkFrameSubmission();
+    app.icet_render_time = 0.0;
+    glGenQueries(2, app.fragment_queries);
+    app.fragment_query_frame = 0;
+    app.fragments_shaded = 0.0;
 
     // Initialize rotations and animation time
     app.rotate_y = 0.0;
@@ -468,56 +1015,46 @@ void init()
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, app.window_width, app.window_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
         glBindTexture(GL_TEXTURE_2D, 0);
+
+        if (app.deferred)
+        {
+            glGenTextures(1, &(app.composite_depth_texture));
+            glBindTexture(GL_TEXTURE_2D, app.composite_depth_texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, app.window_width, app.window_height, 0, GL_RED, GL_FLOAT, NULL);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            app.frame_pixels.resize(4 * app.window_width * app.window_height);
+        }
     }
 
-    // Lights
-    glm::vec3 ambient = glm::vec3(0.2, 0.2, 0.2);
-    glm::vec3 point_light_pos = glm::vec3(40.0, 28.0, -100.0);
-    glm::vec3 point_light_col = glm::vec3(1.0, 1.0, 1.0);
-    glm::vec2 point_light_atten = glm::vec2(50.0, 250.0);
+    // Upload static uniforms (lights are shared by all lit programs)
+    glBindBuffer(GL_UNIFORM_BUFFER, app.light_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), &lights, GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
-    // Upload static uniforms
-    glUseProgram(app.glsl_program["color"].program);
-    glUniform3fv(app.glsl_program["color"].uniforms["camera_position"], 1, glm::value_ptr(app.camera_position));
-    glUniform3fv(app.glsl_program["color"].uniforms["light_ambient"], 1, glm::value_ptr(ambient));
-    glUniform1i(app.glsl_program["color"].uniforms["num_lights"], 1);
-    glUniform3fv(app.glsl_program["color"].uniforms["light_position[0]"], 1, glm::value_ptr(point_light_pos));
-    glUniform3fv(app.glsl_program["color"].uniforms["light_color[0]"], 1, glm::value_ptr(point_light_col));
-    glUniform2fv(app.glsl_program["color"].uniforms["light_attenuation[0]"], 1, glm::value_ptr(point_light_atten));
-    glUniform1i(app.glsl_program["color"].uniforms["num_spotlights"], 0);
-    
-    glUseProgram(app.glsl_program["texture"].program);
-    glUniform3fv(app.glsl_program["texture"].uniforms["camera_position"], 1, glm::value_ptr(app.camera_position));
-    glUniform3fv(app.glsl_program["texture"].uniforms["light_ambient"], 1, glm::value_ptr(ambient));
-    glUniform1i(app.glsl_program["texture"].uniforms["num_lights"], 1);
-    glUniform3fv(app.glsl_program["texture"].uniforms["light_position[0]"], 1, glm::value_ptr(point_light_pos));
-    glUniform3fv(app.glsl_program["texture"].uniforms["light_color[0]"], 1, glm::value_ptr(point_light_col));
-    glUniform2fv(app.glsl_program["texture"].uniforms["light_attenuation[0]"], 1, glm::value_ptr(point_light_atten));
-    glUniform1i(app.glsl_program["texture"].uniforms["num_spotlights"], 0);
+    glUseProgram(app.texture_program->program);
+    glUniform1i(app.texture_program->loc.image, 0);
 
     glUseProgram(0);
 }
 
 void doFrame()
 {
+    // Refresh visible groups from a composited object ID frame
+    if (app.visibility_refresh > 0 && app.frame_count % app.visibility_refresh == 0)
+    {
+        updateVisibility();
+    }
+
     // Offscreen render and composit
-    glm::dmat4 modelview_matrix = app.view_matrix * app.model_matrix;
-#ifdef USE_ICET_OGL3
-    app.image = icetGL3DrawFrame(glm::value_ptr(app.projection_matrix),
-                                 glm::value_ptr(modelview_matrix));
-    double read_time, compress_time;
-    icetGetDoublev(ICET_BUFFER_READ_TIME, &read_time);
-    app.pixel_read_time += read_time;
-    icetGetDoublev(ICET_COMPRESS_TIME, &compress_time);
-    app.pixel_compress_time += compress_time;
-#else
-    app.image = icetDrawFrame(glm::value_ptr(app.projection_matrix),
-                              glm::value_ptr(app.view_matrix),
-                              glm::value_ptr(app.background_color));
-    double compress_time;
-    icetGetDoublev(ICET_COMPRESS_TIME, &compress_time);
-    app.pixel_compress_time += compress_time;
-#endif
+    compositeFrame();
+
+    // Occlusion queries of the next frame test against everyone's geometry
+    if (app.occlusion_framebuffer != 0)
+    {
+        shareOcclusionDepth();
+    }
 
     // Render composited image to fullscreen quad on screen of rank 0
     display();
@@ -559,12 +1096,7 @@ void doFrame()
 
     //double dt = now - app.render_time;
     //app.rotate_y -= 15.0 * dt;
-    app.rotate_y -= 2.0;
-    app.model_matrix = glm::translate(glm::dmat4(1.0), glm::dvec3(40.0, 28.0, -20.0));
-    app.model_matrix = glm::rotate(app.model_matrix, glm::radians(app.rotate_y), glm::dvec3(0.0, 1.0, 0.0));
-    app.model_matrix = glm::translate(app.model_matrix, glm::dvec3(-40.0, -28.0, 20.0));
-    app.normal_matrix = glm::inverse(app.model_matrix);
-    app.normal_matrix = glm::transpose(app.normal_matrix);
+    rotateModel();
 
     app.render_time = now;
 
@@ -572,14 +1104,72 @@ void doFrame()
     app.frame_count++;
 }
 
+void compositeFrame()
+{
+    // Render and composite the current view (sort-first tiles are collected on rank 0)
+    glm::dmat4 modelview_matrix = app.view_matrix * app.model_matrix;
+#ifdef USE_ICET_OGL3
+    app.image = icetGL3DrawFrame(glm::value_ptr(app.projection_matrix),
+                                 glm::value_ptr(modelview_matrix));
+    double read_time, compress_time;
+    icetGetDoublev(ICET_BUFFER_READ_TIME, &read_time);
+    app.pixel_read_time += read_time;
+    icetGetDoublev(ICET_COMPRESS_TIME, &compress_time);
+    app.pixel_compress_time += compress_time;
+#else
+    app.image = icetDrawFrame(glm::value_ptr(app.projection_matrix),
+                              glm::value_ptr(app.view_matrix),
+                              glm::value_ptr(app.background_color));
+    double compress_time;
+    icetGetDoublev(ICET_COMPRESS_TIME, &compress_time);
+    app.pixel_compress_time += compress_time;
+#endif
+    double icet_render_time;
+    icetGetDoublev(ICET_RENDER_TIME, &icet_render_time);
+    app.icet_render_time += icet_render_time;
+
+    // Collect each rank's displayed tile on rank 0
+    if (app.sort_first)
+    {
+        gatherTiles();
+    }
+}
+
+void rotateModel()
+{
+    // Advance the animation by one frame
+    app.rotate_y -= 2.0;
+    app.model_matrix = glm::translate(glm::dmat4(1.0), app.rotation_center);
+    app.model_matrix = glm::rotate(app.model_matrix, glm::radians(app.rotate_y), glm::dvec3(0.0, 1.0, 0.0));
+    app.model_matrix = glm::translate(app.model_matrix, -app.rotation_center);
+    app.normal_matrix = glm::inverse(app.model_matrix);
+    app.normal_matrix = glm::transpose(app.normal_matrix);
+}
+
 void renderIceTOGL3(const IceTDouble *projection_matrix, const IceTDouble *modelview_matrix,
                     const IceTInt *readback_viewport, IceTUInt framebuffer_id)
 {
     // Render to IceT framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
 
-    // Render
-    render();
+    // Each tile is rendered with its own projection (supplied by IceT)
+    if (app.sort_first)
+    {
+        app.render_projection_matrix = glm::make_mat4(projection_matrix);
+    }
+
+    // Render (reverse-Z renders offscreen, then writes IceT's depth convention into its framebuffer)
+    if (app.reverse_z)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, app.framebuffer);
+        render();
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
+        resolveReverseZ();
+    }
+    else
+    {
+        render();
+    }
 
     // Deselect IceT framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -592,11 +1182,22 @@ void renderIceTGeneric(const IceTDouble *projection_matrix, const IceTDouble *mo
     // Render to app's framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, app.framebuffer);
 
+    // Each tile is rendered with its own projection (supplied by IceT)
+    if (app.sort_first)
+    {
+        app.render_projection_matrix = glm::make_mat4(projection_matrix);
+        glViewport(0, 0, icetImageGetWidth(result), icetImageGetHeight(result));
+    }
+
     // Render
     render();
 
     // Deselect app's framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (app.sort_first)
+    {
+        glViewport(0, 0, app.window_width, app.window_height);
+    }
 
     // Copy image to IceT buffer
     glFinish();
@@ -611,81 +1212,246 @@ void renderIceTGeneric(const IceTDouble *projection_matrix, const IceTDouble *mo
     glBindTexture(GL_TEXTURE_2D, app.framebuffer_depth);
     glGetTexImage(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, GL_FLOAT, depth);
     glBindTexture(GL_TEXTURE_2D, 0);
+    if (app.reverse_z)
+    {
+        // IceT composites with smaller depth in front and treats 1 as background: negating is exact,
+        // whereas 1 - depth would round away the precision reverse-Z keeps for far geometry
+        int i;
+        int num_pixels = icetImageGetWidth(result) * icetImageGetHeight(result);
+        for (i = 0; i < num_pixels; i++)
+        {
+            depth[i] = (depth[i] > 0.0f) ? -depth[i] : 1.0f;
+        }
+    }
 
     double end = MPI_Wtime();
     app.pixel_read_time += end - start;
 }
 
-void render()
+void createRenderFramebuffer()
 {
-    // Render
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Offscreen color and depth targets of the rank's render
+    glGenTextures(1, &(app.framebuffer_texture));
+    glBindTexture(GL_TEXTURE_2D, app.framebuffer_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, app.render_width, app.render_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-    float mat4_proj[16], mat4_model[16], mat3_norm[9], mat4_view[16];
-    mat4ToFloatArray(app.projection_matrix, mat4_proj);
-    mat4ToFloatArray(app.view_matrix, mat4_view);
-    mat4ToFloatArray(app.model_matrix, mat4_model);
-    mat3ToFloatArray(app.normal_matrix, mat3_norm);
-
-    glUseProgram(app.glsl_program["color"].program);
-    glUniformMatrix4fv(app.glsl_program["color"].uniforms["projection_matrix"], 1, GL_FALSE, mat4_proj);
-    glUniformMatrix4fv(app.glsl_program["color"].uniforms["model_matrix"], 1, GL_FALSE, mat4_model);
-    glUniformMatrix3fv(app.glsl_program["color"].uniforms["normal_matrix"], 1, GL_FALSE, mat3_norm);
-    glUniformMatrix4fv(app.glsl_program["color"].uniforms["view_matrix"], 1, GL_FALSE, mat4_view);
-    glUseProgram(app.glsl_program["texture"].program);
-    glUniformMatrix4fv(app.glsl_program["texture"].uniforms["projection_matrix"], 1, GL_FALSE, mat4_proj);
-    glUniformMatrix4fv(app.glsl_program["texture"].uniforms["model_matrix"], 1, GL_FALSE, mat4_model);
-    glUniformMatrix3fv(app.glsl_program["texture"].uniforms["normal_matrix"], 1, GL_FALSE, mat3_norm);
-    glUniformMatrix4fv(app.glsl_program["texture"].uniforms["view_matrix"], 1, GL_FALSE, mat4_view);
-    glUseProgram(0);
+    glGenTextures(1, &(app.framebuffer_depth));
+    glBindTexture(GL_TEXTURE_2D, app.framebuffer_depth);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    GLenum depth_format = app.reverse_z ? GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT;
+    glTexImage2D(GL_TEXTURE_2D, 0, depth_format, app.render_width, app.render_height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-    int i, j;
-    for (i = 0; i < app.model_list.size(); i++)
+    glGenFramebuffers(1, &(app.framebuffer));
+    glBindFramebuffer(GL_FRAMEBUFFER, app.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, app.framebuffer_texture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, app.framebuffer_depth, 0);
+    GLenum draw_buffers[1] = {GL_COLOR_ATTACHMENT0};
+    glDrawBuffers(1, draw_buffers);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void render()
+{
+    double submit_start = MPI_Wtime();
+
+    // Render
+    if (app.reverse_z)
     {
-        std::vector<Model> models = app.model_list[i]->getModelList();
-        for (j = 0; j < models.size(); j++)
+        setReverseZ(true);
+    }
+    COUNT_GL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+    // Upload camera and transforms once for all lit programs
+    TransformBlock transforms;
+    mat4ToFloatArray(app.reverse_z_matrix * app.render_projection_matrix, transforms.projection_matrix);
+    mat4ToFloatArray(app.view_matrix, transforms.view_matrix);
+    mat4ToFloatArray(app.model_matrix, transforms.model_matrix);
+    mat3ToStd140Array(app.normal_matrix, transforms.normal_matrix);
+    memcpy(transforms.camera_position, glm::value_ptr(app.camera_position), 3 * sizeof(float));
+    transforms.camera_position[3] = 1.0;
+    COUNT_GL(glBindBufferBase(GL_UNIFORM_BUFFER, TRANSFORM_BLOCK_BINDING, app.transform_ubo));
+    COUNT_GL(glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(TransformBlock), &transforms));
+    COUNT_GL(glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, app.light_ubo));
+
+    // Object ID frames draw every group and are timed separately (see updateVisibility)
+    if (app.id_pass)
+    {
+        drawObjectIds();
+        if (app.reverse_z)
         {
-            if (app.color_by_rank)
-            {
-                glUseProgram(app.glsl_program["color"].program);
-                std::string program_name = "color";
-                Material mat = app.model_list[i]->getMaterial(models[j].material_name);
+            setReverseZ(false);
+        }
+        return;
+    }
 
-                glUniform3fv(app.glsl_program[program_name].uniforms["material_color"], 1, RANK_COLORS[app.rank]);
-                glUniform3fv(app.glsl_program[program_name].uniforms["material_specular"], 1, glm::value_ptr(mat.specular));
-                glUniform1f(app.glsl_program[program_name].uniforms["material_shininess"], mat.shininess);
-            }
-            else
-            {
-                std::string program_name;
-                Material mat = app.model_list[i]->getMaterial(models[j].material_name);
+    // Cull groups whose bounding boxes were hidden in earlier frames
+    if (app.occlusion_culling)
+    {
+        updateOcclusionResults();
+    }
 
-                if (mat.has_texture)
-                {
-                    glUseProgram(app.glsl_program["texture"].program);
-                    program_name = "texture";
+    // Re-sort draws if visibility has changed
+    if (app.render_queue_dirty)
+    {
+        buildRenderQueue();
+    }
 
-                    glActiveTexture(GL_TEXTURE0);
-                    glBindTexture(GL_TEXTURE_2D, mat.texture_id);
-                    glUniform1i(app.glsl_program[program_name].uniforms["image"], 0);
-                }
-                else
-                {
-                    glUseProgram(app.glsl_program["color"].program);
-                    program_name = "color";
-                }
+    COUNT_GL(glActiveTexture(GL_TEXTURE0));
+    if (app.deferred)
+    {
+        // G-buffer values (normal, material ID) must not be blended
+        COUNT_GL(glDisable(GL_BLEND));
+    }
+    if (app.depth_prepass)
+    {
+        // Lay down depth first so the lighting shaders only run on the visible fragment of each pixel
+        COUNT_GL(glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE));
+        drawRenderQueue(app.depth_program);
+        COUNT_GL(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+        COUNT_GL(glDepthFunc(GL_EQUAL));
+        COUNT_GL(glDepthMask(GL_FALSE));
+    }
 
-                glUniform3fv(app.glsl_program[program_name].uniforms["material_color"], 1, glm::value_ptr(mat.color));
-                glUniform3fv(app.glsl_program[program_name].uniforms["material_specular"], 1, glm::value_ptr(mat.specular));
-                glUniform1f(app.glsl_program[program_name].uniforms["material_shininess"], mat.shininess);
-            }
-            glBindVertexArray(models[j].vertex_array);
-            glDrawElements(GL_TRIANGLES, models[j].face_index_count, GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
+    // Samples passing the depth test approximate fragments shaded in the lit pass
+    int query = app.fragment_query_frame % 2;
+    COUNT_GL(glBeginQuery(GL_SAMPLES_PASSED, app.fragment_queries[query]));
+    drawRenderQueue(app.deferred ? app.gbuffer_program : NULL);
+    COUNT_GL(glEndQuery(GL_SAMPLES_PASSED));
+    if (app.fragment_query_frame > 0)
+    {
+        GLuint samples;
+        COUNT_GL(glGetQueryObjectuiv(app.fragment_queries[1 - query], GL_QUERY_RESULT, &samples));
+        app.fragments_shaded += samples;
+    }
+    app.fragment_query_frame++;
+
+    if (app.depth_prepass)
+    {
+        COUNT_GL(glDepthFunc(app.reverse_z ? GL_GREATER : GL_LESS));
+        COUNT_GL(glDepthMask(GL_TRUE));
+    }
+    if (app.deferred)
+    {
+        COUNT_GL(glEnable(GL_BLEND));
+    }
+
+    // Test bounding boxes against the composited depth of the previous frame if shared, otherwise
+    // against the rank's finished depth buffer (results are read in a later frame)
+    if (app.occlusion_culling)
+    {
+        glm::vec3 camera = glm::vec3(glm::inverse(app.model_matrix) * glm::dvec4(glm::dvec3(app.camera_position), 1.0));
+        GLint framebuffer, viewport[4];
+        if (app.occlusion_framebuffer != 0)
+        {
+            COUNT_GL(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer));
+            COUNT_GL(glGetIntegerv(GL_VIEWPORT, viewport));
+            COUNT_GL(glBindFramebuffer(GL_FRAMEBUFFER, app.occlusion_framebuffer));
+            COUNT_GL(glViewport(0, 0, app.occlusion_depth_width, app.occlusion_depth_height));
         }
+        COUNT_GL(glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE));
+        COUNT_GL(glDepthMask(GL_FALSE));
+        COUNT_GL(glDepthFunc(app.reverse_z ? GL_GEQUAL : GL_LEQUAL));
+        COUNT_GL(glUseProgram(app.bbox_program->program));
+        COUNT_GL(glBindVertexArray(app.box_vertex_array));
+        int queries = issueOcclusionQueries(0, camera);
+        COUNT_GL(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+        COUNT_GL(glDepthMask(GL_TRUE));
+        COUNT_GL(glDepthFunc(app.reverse_z ? GL_GREATER : GL_LESS));
+        if (app.occlusion_framebuffer != 0)
+        {
+            COUNT_GL(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+            COUNT_GL(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
+        }
+        app.occlusion_queries += queries;
     }
+    COUNT_GL(glBindVertexArray(0));
 
+    COUNT_GL(glUseProgram(0));
+    if (app.reverse_z)
+    {
+        setReverseZ(false);
+    }
+    app.submit_time += MPI_Wtime() - submit_start;
+}
+
+void setReverseZ(bool enable)
+{
+    // Switch clip range, depth clear value and depth test (display rank's overlay keeps the defaults)
+    if (app.clip_control != NULL)
+    {
+        COUNT_GL(app.clip_control(GL_LOWER_LEFT, enable ? GL_ZERO_TO_ONE : GL_NEGATIVE_ONE_TO_ONE));
+    }
+    COUNT_GL(glClearDepth(enable ? 0.0 : 1.0));
+    COUNT_GL(glDepthFunc(enable ? GL_GREATER : GL_LESS));
+}
+
+void resolveReverseZ()
+{
+    // Copy color and write 1 - depth into the bound (IceT) framebuffer
+    // Known limitation: IceT reads this depth buffer, which only holds [0, 1], so unlike the generic
+    // path (negated depth) far geometry composites with ordinary depth precision
+    glDisable(GL_BLEND);
+    glDepthFunc(GL_ALWAYS);
+    glUseProgram(app.depth_resolve_program->program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, app.framebuffer_texture);
+    glUniform1i(app.depth_resolve_program->loc.image, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, app.framebuffer_depth);
+    glUniform1i(app.depth_resolve_program->loc.depth_buffer, 1);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(app.resolve_vertex_array);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
     glUseProgram(0);
+    glDepthFunc(GL_LESS);
+    glEnable(GL_BLEND);
+}
+
+float compositedToRenderDepth(float depth)
+{
+    // Depth of a composited (IceT) pixel in the convention the frame was rendered with
+    if (!app.reverse_z)
+    {
+        return depth;
+    }
+#ifdef USE_ICET_OGL3
+    return 1.0f - depth;
+#else
+    return (depth >= 1.0f) ? 0.0f : -depth;
+#endif
+}
+
+void fitDepthRange(const float bbox[6])
+{
+    // Near and far planes enclosing the scene at any rotation about the y axis through rotation_center
+    int i;
+    float local_min[3] = {bbox[0], bbox[2], bbox[4]};
+    float local_max[3] = {bbox[1], bbox[3], bbox[5]};
+    float global_min[3], global_max[3];
+    MPI_Allreduce(local_min, global_min, 3, MPI_FLOAT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(local_max, global_max, 3, MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD);
+    double radius = 0.0;
+    for (i = 0; i < 8; i++)
+    {
+        glm::dvec3 corner = glm::dvec3((i & 1) ? global_max[0] : global_min[0],
+                                       (i & 2) ? global_max[1] : global_min[1],
+                                       (i & 4) ? global_max[2] : global_min[2]);
+        radius = std::max(radius, glm::length(corner - app.rotation_center));
+    }
+    double distance = glm::length(glm::dvec3(app.camera_position) - app.rotation_center);
+    app.near_plane = std::max(distance - radius, 0.1);
+    app.far_plane = distance + radius;
+    app.projection_matrix = glm::perspective(glm::radians(60.0), (double)app.window_width / (double)app.window_height,
+                                             app.near_plane, app.far_plane);
+    app.render_projection_matrix = app.projection_matrix;
 }
 
 void display()
@@ -695,45 +1461,52 @@ void display()
 
     if (app.rank == 0)
     {
-        glUseProgram(app.glsl_program["nolight"].program);
+        glUseProgram(app.nolight_program->program);
         
         float mat4_projection[16], mat4_modelview[16];
         mat4ToFloatArray(glm::ortho(0.0, (double)app.window_width, 0.0, (double)app.window_height, -1.0, 1.0), mat4_projection);
         mat4ToFloatArray(app.composite_mv_matrix, mat4_modelview);
-        glUniformMatrix4fv(app.glsl_program["nolight"].uniforms["projection_matrix"], 1, GL_FALSE, mat4_projection);
-        glUniformMatrix4fv(app.glsl_program["nolight"].uniforms["modelview_matrix"], 1, GL_FALSE, mat4_modelview);
+        glUniformMatrix4fv(app.nolight_program->loc.projection_matrix, 1, GL_FALSE, mat4_projection);
+        glUniformMatrix4fv(app.nolight_program->loc.modelview_matrix, 1, GL_FALSE, mat4_modelview);
    
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, app.composite_texture);
-        IceTUByte *pixels = icetImageGetColorub(app.image);
+        IceTUByte *pixels = app.sort_first ? app.frame_pixels.data() : icetImageGetColorub(app.image);
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, app.window_width, app.window_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-        glUniform1i(app.glsl_program["nolight"].uniforms["image"], 0);
+        glUniform1i(app.nolight_program->loc.image, 0);
 
         glBindVertexArray(app.plane_vertex_array);
         
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+        if (app.deferred)
+        {
+            drawDeferredLighting(mat4_projection, mat4_modelview);
+        }
+        else
+        {
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+        }
         
         if (app.show_fps)
         {
             mat4ToFloatArray(app.text_background_mv_matrix, mat4_modelview);
             glBindTexture(GL_TEXTURE_2D, app.text_background_texture);
-            glUniformMatrix4fv(app.glsl_program["nolight"].uniforms["modelview_matrix"], 1, GL_FALSE, mat4_modelview);
+            glUniformMatrix4fv(app.nolight_program->loc.modelview_matrix, 1, GL_FALSE, mat4_modelview);
             
             glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
             
             
-            glUseProgram(app.glsl_program["text"].program);
+            glUseProgram(app.text_program->program);
             
             mat4ToFloatArray(app.text_mv_matrix, mat4_modelview);
-            glUniformMatrix4fv(app.glsl_program["text"].uniforms["projection_matrix"], 1, GL_FALSE, mat4_projection);
-            glUniformMatrix4fv(app.glsl_program["text"].uniforms["modelview_matrix"], 1, GL_FALSE, mat4_modelview);
+            glUniformMatrix4fv(app.text_program->loc.projection_matrix, 1, GL_FALSE, mat4_projection);
+            glUniformMatrix4fv(app.text_program->loc.modelview_matrix, 1, GL_FALSE, mat4_modelview);
             
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, app.text_texture);
-            glUniform1i(app.glsl_program["text"].uniforms["image"], 0);
+            glUniform1i(app.text_program->loc.image, 0);
             
             float white[3] = {1.0, 1.0, 1.0};
-            glUniform3fv(app.glsl_program["text"].uniforms["font_color"], 1, white);
+            glUniform3fv(app.text_program->loc.font_color, 1, white);
             
             glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
         }
@@ -744,6 +1517,12 @@ void display()
 
         if (app.outfile != "")
         {
+            if (app.deferred)
+            {
+                // Composited image holds the G-buffer, so save the shaded result instead
+                glReadPixels(0, 0, app.window_width, app.window_height, GL_RGBA, GL_UNSIGNED_BYTE, app.frame_pixels.data());
+                pixels = app.frame_pixels.data();
+            }
             int i;
             char filename[128];
             snprintf(filename, 128, "%s_%05d.ppm", app.outfile.c_str(), app.frame_count);
@@ -762,6 +1541,1076 @@ void display()
     glfwSwapBuffers(app.window);
 }
 
+void createDrawList()
+{
+    // One draw per material group of each model
+    int i, j;
+    for (i = 0; i < app.model_list.size(); i++)
+    {
+        std::vector<Model>& models = app.model_list[i]->getModelList();
+        for (j = 0; j < models.size(); j++)
+        {
+            Material& mat = app.model_list[i]->getMaterial(models[j].material_name);
+            DrawItem item;
+            MaterialEntry entry;
+            glm::vec4 texture_average = glm::vec4(0.0, 0.0, 0.0, 0.0);
+            entry.color[3] = -1.0;
+            if (app.color_by_rank)
+            {
+                item.program = app.color_program;
+                item.texture = 0;
+                memcpy(entry.color, RANK_COLORS[app.rank], 3 * sizeof(float));
+            }
+            else
+            {
+                item.program = mat.has_texture ? app.texture_program : app.color_program;
+                item.texture = 0;
+                memcpy(entry.color, glm::value_ptr(mat.color), 3 * sizeof(float));
+                if (mat.has_texture)
+                {
+                    entry.color[3] = textureArrayLayer(mat, &(item.texture));
+                    texture_average = mat.texture_average;
+                }
+            }
+            memcpy(entry.specular, glm::value_ptr(mat.specular), 3 * sizeof(float));
+            entry.specular[3] = mat.shininess;
+            item.material_index = addMaterial(entry, texture_average);
+            item.model = &(models[j]);
+            item.face_index_count = models[j].face_index_count;
+            item.batch = -1;
+            item.base_vertex = 0;
+            item.first_index = 0;
+            item.visible = true;
+            item.occluded = false;
+            app.draw_list.push_back(item);
+        }
+    }
+
+    // Textured draws sample from the texture array of their texture's size
+    createTextureArrays();
+    createDrawBatches();
+    buildRenderQueue();
+}
+
+GLint textureArrayLayer(const Material& mat, GLuint *texture)
+{
+    // Layer of a material texture in the array for its size (added on first use)
+    int i, j;
+    for (i = 0; i < app.texture_arrays.size(); i++)
+    {
+        for (j = 0; j < app.texture_arrays[i].sources.size(); j++)
+        {
+            if (app.texture_arrays[i].sources[j] == mat.texture_id)
+            {
+                *texture = app.texture_arrays[i].texture;
+                return j;
+            }
+        }
+    }
+
+    GLint width, height, max_layers;
+    glBindTexture(GL_TEXTURE_2D, mat.texture_id);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    for (i = 0; i < app.texture_arrays.size(); i++)
+    {
+        TextureArray *array = &(app.texture_arrays[i]);
+        if (array->width == width && array->height == height && array->sources.size() < max_layers)
+        {
+            break;
+        }
+    }
+    if (i == app.texture_arrays.size())
+    {
+        // Storage is allocated once every layer is known (see createTextureArrays)
+        TextureArray array;
+        glGenTextures(1, &(array.texture));
+        array.width = width;
+        array.height = height;
+        app.texture_arrays.push_back(array);
+    }
+    TextureArray *array = &(app.texture_arrays[i]);
+    array->sources.push_back(mat.texture_id);
+    *texture = array->texture;
+    return array->sources.size() - 1;
+}
+
+void createTextureArrays()
+{
+    // Copy each material texture into its layer (same size, so no resampling)
+    int i, j;
+    GLuint framebuffers[2];
+    glGenFramebuffers(2, framebuffers);
+    for (i = 0; i < app.texture_arrays.size(); i++)
+    {
+        const TextureArray *array = &(app.texture_arrays[i]);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array->texture);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_SRGB8_ALPHA8, array->width, array->height,
+                     array->sources.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+        for (j = 0; j < array->sources.size(); j++)
+        {
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, array->sources[j], 0);
+            glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, array->texture, 0, j);
+            glBlitFramebuffer(0, 0, array->width, array->height, 0, 0, array->width, array->height,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // Mipmaps are generated per layer, so neighboring materials never bleed into each other
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glDeleteFramebuffers(2, framebuffers);
+
+    // Original textures are no longer sampled (also drops them from the loader's cache and materials)
+    for (i = 0; i < app.model_list.size(); i++)
+    {
+        app.model_list[i]->releaseTextures();
+    }
+}
+
+void createDrawBatches()
+{
+    // Assign draws to batches (in sorted order, so each batch is a contiguous run)
+    int i, j;
+    std::vector<DrawItem*> items(app.draw_list.size());
+    for (i = 0; i < app.draw_list.size(); i++)
+    {
+        items[i] = &(app.draw_list[i]);
+    }
+    std::stable_sort(items.begin(), items.end(), drawItemLess);
+
+    std::vector<int> batch_start;
+    std::vector<GLuint> batch_vertex_count;
+    for (i = 0; i < items.size(); i++)
+    {
+        DrawItem *item = items[i];
+        GLint page = item->material_index / MAX_MATERIALS;
+        if (app.draw_batches.empty() || item->program != app.draw_batches.back().program ||
+            item->texture != app.draw_batches.back().texture || page != app.draw_batches.back().material_page)
+        {
+            DrawBatch batch;
+            batch.program = item->program;
+            batch.texture = item->texture;
+            batch.material_page = page;
+            app.draw_batches.push_back(batch);
+            batch_start.push_back(i);
+            batch_vertex_count.push_back(0);
+        }
+        // OBJ groups have one vertex per index, so vertex and index offsets match
+        item->batch = app.draw_batches.size() - 1;
+        item->base_vertex = batch_vertex_count.back();
+        item->first_index = batch_vertex_count.back();
+        batch_vertex_count.back() += item->face_index_count;
+    }
+    batch_start.push_back(items.size());
+
+    // Copy group geometry into shared buffers for each batch
+    for (i = 0; i < app.draw_batches.size(); i++)
+    {
+        DrawBatch& batch = app.draw_batches[i];
+        GLuint num_verts = batch_vertex_count[i];
+        bool textured = batch.texture != 0;
+
+        glGenVertexArrays(1, &(batch.vertex_array));
+        glBindVertexArray(batch.vertex_array);
+        glGenBuffers(5, batch.buffers);
+
+        glBindBuffer(GL_ARRAY_BUFFER, batch.buffers[0]);
+        glBufferData(GL_ARRAY_BUFFER, 3 * num_verts * sizeof(GLfloat), NULL, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(app.vertex_position_attrib);
+        glVertexAttribPointer(app.vertex_position_attrib, 3, GL_FLOAT, false, 0, 0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, batch.buffers[1]);
+        glBufferData(GL_ARRAY_BUFFER, 3 * num_verts * sizeof(GLfloat), NULL, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(app.vertex_normal_attrib);
+        glVertexAttribPointer(app.vertex_normal_attrib, 3, GL_FLOAT, false, 0, 0);
+
+        if (textured)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, batch.buffers[2]);
+            glBufferData(GL_ARRAY_BUFFER, 2 * num_verts * sizeof(GLfloat), NULL, GL_STATIC_DRAW);
+            glEnableVertexAttribArray(app.vertex_texcoord_attrib);
+            glVertexAttribPointer(app.vertex_texcoord_attrib, 2, GL_FLOAT, false, 0, 0);
+        }
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.buffers[4]);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, num_verts * sizeof(GLuint), NULL, GL_STATIC_DRAW);
+
+        // Per-vertex material index (within the batch's material page)
+        std::vector<GLushort> vertex_materials(num_verts);
+        for (j = batch_start[i]; j < batch_start[i + 1]; j++)
+        {
+            const DrawItem *item = items[j];
+            std::fill(vertex_materials.begin() + item->base_vertex,
+                      vertex_materials.begin() + item->base_vertex + item->face_index_count,
+                      item->material_index % MAX_MATERIALS);
+
+            copyBuffer(item->model->vertex_position_buffer, batch.buffers[0],
+                       3 * item->base_vertex * sizeof(GLfloat), 3 * item->face_index_count * sizeof(GLfloat));
+            copyBuffer(item->model->vertex_normal_buffer, batch.buffers[1],
+                       3 * item->base_vertex * sizeof(GLfloat), 3 * item->face_index_count * sizeof(GLfloat));
+            if (textured)
+            {
+                copyBuffer(item->model->vertex_texcoord_buffer, batch.buffers[2],
+                           2 * item->base_vertex * sizeof(GLfloat), 2 * item->face_index_count * sizeof(GLfloat));
+            }
+            copyBuffer(item->model->vertex_index_buffer, batch.buffers[4],
+                       item->first_index * sizeof(GLuint), item->face_index_count * sizeof(GLuint));
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, batch.buffers[3]);
+        glBufferData(GL_ARRAY_BUFFER, num_verts * sizeof(GLushort), vertex_materials.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(app.vertex_material_attrib);
+        glVertexAttribIPointer(app.vertex_material_attrib, 1, GL_UNSIGNED_SHORT, 0, 0);
+
+        glBindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Per-group buffers are no longer needed
+    for (i = 0; i < app.model_list.size(); i++)
+    {
+        app.model_list[i]->releaseModelBuffers();
+    }
+}
+
+void buildRenderQueue()
+{
+    // Queue visible draws (in load order if state sorting is disabled)
+    int i;
+    app.render_queue.clear();
+    for (i = 0; i < app.draw_list.size(); i++)
+    {
+        if (app.draw_list[i].visible && !app.draw_list[i].occluded)
+        {
+            app.render_queue.push_back(&(app.draw_list[i]));
+        }
+    }
+    if (app.state_sort)
+    {
+        std::sort(app.render_queue.begin(), app.render_queue.end(), drawItemLess);
+    }
+
+    // Gather visible draws of each batch for multi-draw
+    for (i = 0; i < app.draw_batches.size(); i++)
+    {
+        app.draw_batches[i].counts.clear();
+        app.draw_batches[i].index_offsets.clear();
+        app.draw_batches[i].base_vertices.clear();
+    }
+    for (i = 0; i < app.render_queue.size(); i++)
+    {
+        const DrawItem *item = app.render_queue[i];
+        DrawBatch& batch = app.draw_batches[item->batch];
+        batch.counts.push_back(item->face_index_count);
+        batch.index_offsets.push_back((const GLvoid*)(item->first_index * sizeof(GLuint)));
+        batch.base_vertices.push_back(item->base_vertex);
+    }
+    app.render_queue_dirty = false;
+}
+
+bool drawItemLess(const DrawItem *a, const DrawItem *b)
+{
+    // Order by program, then texture, then material
+    if (a->program->program != b->program->program) return a->program->program < b->program->program;
+    if (a->texture != b->texture) return a->texture < b->texture;
+    if (a->material_index != b->material_index) return a->material_index < b->material_index;
+    return a->base_vertex < b->base_vertex;
+}
+
+void benchmarkFrameSubmission()
+{
+    // Time one frame's CPU-side draw submission without issuing GL calls, first the way render()
+    // used to (copying each model list and material, looking programs and uniforms up by string key)
+    // and then through the resolved draw records of the render queue
+    int i, j, k, iterations = 100;
+    volatile GLint sink = 0;
+    const char *program_names[2] = {"color", "texture"};
+    double start = MPI_Wtime();
+    for (i = 0; i < iterations; i++)
+    {
+        for (j = 0; j < 2; j++)
+        {
+            GlslProgram *p = &(app.glsl_program[program_names[j]]);
+            sink += findUniform(p, "projection_matrix") + findUniform(p, "model_matrix") +
+                    findUniform(p, "normal_matrix") + findUniform(p, "view_matrix");
+        }
+        for (j = 0; j < app.model_list.size(); j++)
+        {
+            std::vector<Model> models = app.model_list[j]->getModelList();
+            for (k = 0; k < models.size(); k++)
+            {
+                Material mat = app.model_list[j]->getMaterial(models[k].material_name);
+                std::string program_name = mat.has_texture ? "texture" : "color";
+                GlslProgram *p = &(app.glsl_program[program_name]);
+                sink += p->program + findUniform(p, "material_color") + findUniform(p, "material_specular") +
+                        findUniform(p, "material_shininess") + models[k].vertex_array + models[k].face_index_count;
+            }
+        }
+    }
+    app.lookup_time_map = (MPI_Wtime() - start) / iterations;
+
+    start = MPI_Wtime();
+    for (i = 0; i < iterations; i++)
+    {
+        for (j = 0; j < app.render_queue.size(); j++)
+        {
+            const DrawItem *item = app.render_queue[j];
+            const DrawBatch *batch = &(app.draw_batches[item->batch]);
+            sink += batch->program->program + batch->texture + batch->material_page + batch->vertex_array +
+                    item->face_index_count + item->first_index + item->base_vertex;
+        }
+    }
+    app.lookup_time_resolved = (MPI_Wtime() - start) / iterations;
+}
+
+void drawRenderQueue(GlslProgram *override_program)
+{
+    // Draw visible groups
+    int i;
+    BoundState bound = {NULL, 0, -1, 0};
+    if (app.multi_draw && app.state_sort)
+    {
+        // One multi-draw per batch of visible groups sharing program, texture and material page
+        for (i = 0; i < app.draw_batches.size(); i++)
+        {
+            const DrawBatch *batch = &(app.draw_batches[i]);
+            if (batch->counts.empty())
+            {
+                continue;
+            }
+            bindBatch(batch, &bound, true, override_program);
+            COUNT_GL(glMultiDrawElementsBaseVertex(GL_TRIANGLES, batch->counts.data(), GL_UNSIGNED_INT,
+                                                   batch->index_offsets.data(), batch->counts.size(),
+                                                   batch->base_vertices.data()));
+        }
+    }
+    else
+    {
+        // Draw queue one group at a time (skipping redundant state changes if sorted)
+        for (i = 0; i < app.render_queue.size(); i++)
+        {
+            const DrawItem *item = app.render_queue[i];
+            bindBatch(&(app.draw_batches[item->batch]), &bound, app.state_sort, override_program);
+            COUNT_GL(glDrawElementsBaseVertex(GL_TRIANGLES, item->face_index_count, GL_UNSIGNED_INT,
+                                              (const GLvoid*)(item->first_index * sizeof(GLuint)), item->base_vertex));
+        }
+    }
+}
+
+void bindBatch(const DrawBatch *batch, BoundState *bound, bool skip_redundant, GlslProgram *override_program)
+{
+    // Bind program, texture, material page and geometry of a batch
+    // An override program (depth or G-buffer) replaces the batch's lit program and needs no material data
+    GlslProgram *program = (override_program != NULL) ? override_program : batch->program;
+    bool program_changed = !skip_redundant || program != bound->program;
+    if (program_changed)
+    {
+        COUNT_GL(glUseProgram(program->program));
+        bound->program = program;
+    }
+    if (override_program == NULL)
+    {
+        if (batch->texture != 0 && (!skip_redundant || batch->texture != bound->texture))
+        {
+            COUNT_GL(glBindTexture(GL_TEXTURE_2D_ARRAY, batch->texture));
+            bound->texture = batch->texture;
+        }
+        if (!skip_redundant || batch->material_page != bound->material_page)
+        {
+            COUNT_GL(glBindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, app.material_ubo,
+                                       batch->material_page * MAX_MATERIALS * sizeof(MaterialEntry),
+                                       MAX_MATERIALS * sizeof(MaterialEntry)));
+            bound->material_page = batch->material_page;
+        }
+    }
+    else if (program->loc.material_base >= 0 && (program_changed || batch->material_page != bound->material_page))
+    {
+        // G-buffer stores global material IDs
+        COUNT_GL(glUniform1ui(program->loc.material_base, app.material_id_offset + batch->material_page * MAX_MATERIALS));
+        bound->material_page = batch->material_page;
+    }
+    if (!skip_redundant || batch->vertex_array != bound->vertex_array)
+    {
+        COUNT_GL(glBindVertexArray(batch->vertex_array));
+        bound->vertex_array = batch->vertex_array;
+    }
+}
+
+GLuint addMaterial(const MaterialEntry& entry, glm::vec4 texture_average)
+{
+    // Materials are shared by value, so identical materials from different models use one entry
+    // (layers of different texture arrays share indices, so the texture average tells them apart)
+    std::string key = std::string((const char*)&entry, sizeof(MaterialEntry)) +
+                      std::string((const char*)glm::value_ptr(texture_average), sizeof(glm::vec4));
+    std::map<std::string, GLuint>::iterator found = app.material_lookup.find(key);
+    if (found != app.material_lookup.end())
+    {
+        return found->second;
+    }
+    GLuint index = app.material_table.size();
+    app.material_table.push_back(entry);
+    app.material_averages.push_back(texture_average);
+    app.material_lookup[key] = index;
+    return index;
+}
+
+void createUniformBuffers()
+{
+    // Per-frame transforms
+    glGenBuffers(1, &(app.transform_ubo));
+    glBindBuffer(GL_UNIFORM_BUFFER, app.transform_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(TransformBlock), NULL, GL_DYNAMIC_DRAW);
+
+    // Lights (uploaded in init)
+    glGenBuffers(1, &(app.light_ubo));
+
+    // Materials, padded to whole pages of MAX_MATERIALS entries (16 KB, a multiple of any
+    // uniform buffer offset alignment) so each page can be bound with glBindBufferRange
+    int num_pages = (app.material_table.size() + MAX_MATERIALS - 1) / MAX_MATERIALS;
+    if (num_pages == 0)
+    {
+        num_pages = 1;
+    }
+    glGenBuffers(1, &(app.material_ubo));
+    glBindBuffer(GL_UNIFORM_BUFFER, app.material_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, num_pages * MAX_MATERIALS * sizeof(MaterialEntry), NULL, GL_STATIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, app.material_table.size() * sizeof(MaterialEntry), app.material_table.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void copyBuffer(GLuint src, GLuint dst, GLintptr dst_offset, GLsizeiptr size)
+{
+    glBindBuffer(GL_COPY_READ_BUFFER, src);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, dst);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, dst_offset, size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void updateVisibility()
+{
+    // Composite object IDs of all groups, then keep only the groups that won at least one pixel
+    double start = MPI_Wtime();
+    int i;
+    app.id_pass = true;
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+#ifdef USE_ICET_OGL3
+    glm::dmat4 modelview_matrix = app.view_matrix * app.model_matrix;
+    IceTImage image = icetGL3DrawFrame(glm::value_ptr(app.projection_matrix),
+                                       glm::value_ptr(modelview_matrix));
+#else
+    IceTFloat id_background[4] = {0.0, 0.0, 0.0, 0.0};
+    IceTImage image = icetDrawFrame(glm::value_ptr(app.projection_matrix),
+                                    glm::value_ptr(app.view_matrix),
+                                    id_background);
+#endif
+    glClearColor(app.background_color[0], app.background_color[1], app.background_color[2], app.background_color[3]);
+    app.id_pass = false;
+
+    // Display rank splits the unique IDs into per-rank lists of visible groups
+    std::vector<int> counts(app.num_proc, 0), displacements(app.num_proc, 0);
+    std::vector<GLuint> groups;
+    if (app.rank == 0)
+    {
+        IceTUByte *pixels = icetImageGetColorub(image);
+        int num_pixels = app.window_width * app.window_height;
+        std::vector<GLuint> ids;
+        GLuint previous = 0;
+        for (i = 0; i < num_pixels; i++)
+        {
+            GLuint id = (pixels[4 * i + 0] << 24) | (pixels[4 * i + 1] << 16) | (pixels[4 * i + 2] << 8) | pixels[4 * i + 3];
+            if (id != 0 && id != previous)
+            {
+                ids.push_back(id);
+                previous = id;
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+        // IDs sort by rank, so each rank's groups are contiguous
+        for (i = 0; i < ids.size(); i++)
+        {
+            int rank = ids[i] >> 24;
+            if (rank < app.num_proc)
+            {
+                counts[rank]++;
+                groups.push_back((ids[i] & 0xFFFFFF) - 1);
+            }
+        }
+        for (i = 1; i < app.num_proc; i++)
+        {
+            displacements[i] = displacements[i - 1] + counts[i - 1];
+        }
+    }
+    int num_visible;
+    MPI_Scatter(counts.data(), 1, MPI_INT, &num_visible, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    std::vector<GLuint> visible(num_visible);
+    MPI_Scatterv(groups.data(), counts.data(), displacements.data(), MPI_UNSIGNED,
+                 visible.data(), num_visible, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+
+    for (i = 0; i < app.draw_list.size(); i++)
+    {
+        app.draw_list[i].visible = false;
+    }
+    for (i = 0; i < num_visible; i++)
+    {
+        if (visible[i] < app.draw_list.size())
+        {
+            app.draw_list[visible[i]].visible = true;
+        }
+    }
+    app.render_queue_dirty = true;
+
+    app.visible_groups += num_visible;
+    app.visibility_updates++;
+    app.visibility_time += MPI_Wtime() - start;
+}
+
+void drawObjectIds()
+{
+    // Draw every group with its ID (rank << 24 | group + 1) packed into RGBA8, 0 is background
+    int i;
+    GLuint vertex_array = 0;
+    COUNT_GL(glDisable(GL_BLEND));
+    COUNT_GL(glUseProgram(app.object_id_program->program));
+    for (i = 0; i < app.draw_list.size(); i++)
+    {
+        const DrawItem *item = &(app.draw_list[i]);
+        const DrawBatch *batch = &(app.draw_batches[item->batch]);
+        if (batch->vertex_array != vertex_array)
+        {
+            COUNT_GL(glBindVertexArray(batch->vertex_array));
+            vertex_array = batch->vertex_array;
+        }
+        COUNT_GL(glUniform1ui(app.object_id_program->loc.object_id, ((GLuint)app.rank << 24) | (i + 1)));
+        COUNT_GL(glDrawElementsBaseVertex(GL_TRIANGLES, item->face_index_count, GL_UNSIGNED_INT,
+                                          (const GLvoid*)(item->first_index * sizeof(GLuint)), item->base_vertex));
+    }
+    COUNT_GL(glBindVertexArray(0));
+    COUNT_GL(glUseProgram(0));
+    COUNT_GL(glEnable(GL_BLEND));
+}
+
+void createOcclusionHierarchy()
+{
+    // Bounding volume hierarchy over the rank's groups (leaves hold one group each)
+    int i;
+    std::vector<int> items(app.draw_list.size());
+    for (i = 0; i < items.size(); i++)
+    {
+        items[i] = i;
+    }
+    app.occlusion_nodes.clear();
+    if (!items.empty())
+    {
+        buildOcclusionNode(items, 0, items.size(), -1);
+    }
+    for (i = 0; i < app.occlusion_nodes.size(); i++)
+    {
+        glGenQueries(1, &(app.occlusion_nodes[i].query));
+    }
+    app.box_vertex_array = boxVertexArray();
+}
+
+void createOcclusionDepth()
+{
+    // Low resolution depth target holding the composited depth for occlusion queries
+    // Sort-first composites per tile, so those queries keep testing the rank's own depth only
+    app.occlusion_framebuffer = 0;
+    app.occlusion_depth_texture = 0;
+    if (app.sort_first)
+    {
+        return;
+    }
+    app.occlusion_depth_width = (app.window_width + OCCLUSION_DEPTH_SCALE - 1) / OCCLUSION_DEPTH_SCALE;
+    app.occlusion_depth_height = (app.window_height + OCCLUSION_DEPTH_SCALE - 1) / OCCLUSION_DEPTH_SCALE;
+    app.occlusion_depth.assign(app.occlusion_depth_width * app.occlusion_depth_height, app.reverse_z ? 0.0f : 1.0f);
+
+    glGenTextures(1, &(app.occlusion_depth_texture));
+    glBindTexture(GL_TEXTURE_2D, app.occlusion_depth_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, app.occlusion_depth_width, app.occlusion_depth_height, 0,
+                 GL_DEPTH_COMPONENT, GL_FLOAT, app.occlusion_depth.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &(app.occlusion_framebuffer));
+    glBindFramebuffer(GL_FRAMEBUFFER, app.occlusion_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, app.occlusion_depth_texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void shareOcclusionDepth()
+{
+    // Display rank reduces the composited depth to the farthest value of each block (so a box is
+    // only hidden behind geometry covering the whole block), then every rank uploads it
+    int i, j, x, y;
+    if (app.rank == 0)
+    {
+        IceTFloat *depth = icetImageGetDepthf(app.image);
+        for (j = 0; j < app.occlusion_depth_height; j++)
+        {
+            for (i = 0; i < app.occlusion_depth_width; i++)
+            {
+                float farthest = 0.0f;
+                int x_end = std::min((i + 1) * OCCLUSION_DEPTH_SCALE, app.window_width);
+                int y_end = std::min((j + 1) * OCCLUSION_DEPTH_SCALE, app.window_height);
+                for (y = j * OCCLUSION_DEPTH_SCALE; y < y_end; y++)
+                {
+                    for (x = i * OCCLUSION_DEPTH_SCALE; x < x_end; x++)
+                    {
+                        farthest = std::max(farthest, depth[y * app.window_width + x]);
+                    }
+                }
+                // IceT composites with smaller depth in front, the query pass uses the render's depth
+                app.occlusion_depth[j * app.occlusion_depth_width + i] = compositedToRenderDepth(farthest);
+            }
+        }
+    }
+    MPI_Bcast(app.occlusion_depth.data(), app.occlusion_depth.size(), MPI_FLOAT, 0, MPI_COMM_WORLD);
+
+    glBindTexture(GL_TEXTURE_2D, app.occlusion_depth_texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, app.occlusion_depth_width, app.occlusion_depth_height,
+                    GL_DEPTH_COMPONENT, GL_FLOAT, app.occlusion_depth.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+int buildOcclusionNode(std::vector<int>& items, int begin, int end, int parent)
+{
+    // Split groups at the median of their centers along the longest axis of the node
+    int i;
+    int index = app.occlusion_nodes.size();
+    OcclusionNode node;
+    node.bbox_min = app.draw_list[items[begin]].model->bbox_min;
+    node.bbox_max = app.draw_list[items[begin]].model->bbox_max;
+    for (i = begin + 1; i < end; i++)
+    {
+        node.bbox_min = glm::min(node.bbox_min, app.draw_list[items[i]].model->bbox_min);
+        node.bbox_max = glm::max(node.bbox_max, app.draw_list[items[i]].model->bbox_max);
+    }
+    // Pad so flat groups do not coincide with their own proxy faces
+    glm::vec3 padding = 0.001f * (node.bbox_max - node.bbox_min) + glm::vec3(1.0e-4, 1.0e-4, 1.0e-4);
+    node.bbox_min -= padding;
+    node.bbox_max += padding;
+    node.children[0] = -1;
+    node.children[1] = -1;
+    node.parent = parent;
+    node.item = (end - begin == 1) ? items[begin] : -1;
+    node.query = 0;
+    node.query_pending = false;
+    node.visible = true;
+    node.hidden_results = 0;
+    app.occlusion_nodes.push_back(node);
+    if (end - begin == 1)
+    {
+        return index;
+    }
+
+    glm::vec3 extent = node.bbox_max - node.bbox_min;
+    int axis = (extent.x > extent.y && extent.x > extent.z) ? 0 : ((extent.y > extent.z) ? 1 : 2);
+    int middle = (begin + end) / 2;
+    std::nth_element(items.begin() + begin, items.begin() + middle, items.begin() + end, [axis](int a, int b) {
+        const Model *model_a = app.draw_list[a].model;
+        const Model *model_b = app.draw_list[b].model;
+        return (model_a->bbox_min[axis] + model_a->bbox_max[axis]) < (model_b->bbox_min[axis] + model_b->bbox_max[axis]);
+    });
+    int left = buildOcclusionNode(items, begin, middle, index);
+    int right = buildOcclusionNode(items, middle, end, index);
+    app.occlusion_nodes[index].children[0] = left;
+    app.occlusion_nodes[index].children[1] = right;
+    return index;
+}
+
+void updateOcclusionResults()
+{
+    // Apply query results that are ready (pending ones keep the last known visibility, so no stalls)
+    int i;
+    for (i = 0; i < app.occlusion_nodes.size(); i++)
+    {
+        OcclusionNode *node = &(app.occlusion_nodes[i]);
+        if (!node->query_pending)
+        {
+            continue;
+        }
+        GLuint available, samples;
+        glGetQueryObjectuiv(node->query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            continue;
+        }
+        glGetQueryObjectuiv(node->query, GL_QUERY_RESULT, &samples);
+        node->query_pending = false;
+        if (samples > 0)
+        {
+            // Newly visible: draw the whole subtree and refine with its own queries next time
+            node->hidden_results = 0;
+            if (!node->visible)
+            {
+                setOcclusionSubtreeVisible(i, true);
+            }
+        }
+        else if (node->visible && ++node->hidden_results >= OCCLUSION_HIDDEN_RESULTS)
+        {
+            // Hidden: pull up to the largest hidden ancestor so one query covers it
+            // (a single result is not trusted, since it tests last frame's depth from before the model moved)
+            setOcclusionSubtreeVisible(i, false);
+            int parent = node->parent;
+            while (parent >= 0 && !app.occlusion_nodes[app.occlusion_nodes[parent].children[0]].visible &&
+                   !app.occlusion_nodes[app.occlusion_nodes[parent].children[1]].visible)
+            {
+                app.occlusion_nodes[parent].visible = false;
+                parent = app.occlusion_nodes[parent].parent;
+            }
+        }
+    }
+
+    // Groups of hidden leaves are left out of the render queue
+    int occluded = 0;
+    for (i = 0; i < app.occlusion_nodes.size(); i++)
+    {
+        const OcclusionNode *node = &(app.occlusion_nodes[i]);
+        if (node->item >= 0)
+        {
+            DrawItem *item = &(app.draw_list[node->item]);
+            if (item->occluded == node->visible)
+            {
+                item->occluded = !node->visible;
+                app.render_queue_dirty = true;
+            }
+            occluded += item->occluded ? 1 : 0;
+        }
+    }
+    app.occluded_groups += occluded;
+}
+
+void setOcclusionSubtreeVisible(int node, bool visible)
+{
+    // Mark a node and all of its descendants
+    OcclusionNode *n = &(app.occlusion_nodes[node]);
+    n->visible = visible;
+    n->hidden_results = 0;
+    if (n->item < 0)
+    {
+        setOcclusionSubtreeVisible(n->children[0], visible);
+        setOcclusionSubtreeVisible(n->children[1], visible);
+    }
+}
+
+void checkOcclusionCulling()
+{
+    // Continue the animation for a few untimed frames, compositing each view with and without
+    // occlusion culling, and count the pixels that differ (conservative culling changes none)
+    int i, frame, p;
+    int num_pixels = app.window_width * app.window_height;
+    std::vector<IceTUByte> culled(4 * num_pixels);
+    std::vector<bool> occluded(app.draw_list.size());
+    double tile_gather_time = app.tile_gather_time;
+    app.occlusion_differing_pixels = 0.0;
+    app.occlusion_max_differing_pixels = 0;
+    for (frame = 0; frame < OCCLUSION_CHECK_FRAMES; frame++)
+    {
+        compositeFrame();
+        if (app.rank == 0)
+        {
+            IceTUByte *pixels = app.sort_first ? app.frame_pixels.data() : icetImageGetColorub(app.image);
+            memcpy(culled.data(), pixels, culled.size());
+        }
+        if (app.occlusion_framebuffer != 0)
+        {
+            shareOcclusionDepth();
+        }
+
+        // Same view with every group drawn (pending queries stay pending)
+        for (i = 0; i < app.draw_list.size(); i++)
+        {
+            occluded[i] = app.draw_list[i].occluded;
+            app.draw_list[i].occluded = false;
+        }
+        app.occlusion_culling = false;
+        app.render_queue_dirty = true;
+        compositeFrame();
+        app.occlusion_culling = true;
+        for (i = 0; i < app.draw_list.size(); i++)
+        {
+            app.draw_list[i].occluded = occluded[i];
+        }
+        app.render_queue_dirty = true;
+
+        // Composited colors (G-buffer in deferred mode) are compared exactly
+        if (app.rank == 0)
+        {
+            IceTUByte *pixels = app.sort_first ? app.frame_pixels.data() : icetImageGetColorub(app.image);
+            int differing = 0;
+            for (p = 0; p < num_pixels; p++)
+            {
+                differing += (memcmp(culled.data() + 4 * p, pixels + 4 * p, 4) != 0) ? 1 : 0;
+            }
+            app.occlusion_differing_pixels += differing;
+            app.occlusion_max_differing_pixels = std::max(app.occlusion_max_differing_pixels, differing);
+        }
+
+        rotateModel();
+        app.frame_count++;
+    }
+    app.occlusion_differing_pixels /= OCCLUSION_CHECK_FRAMES;
+    app.tile_gather_time = tile_gather_time;
+}
+
+int issueOcclusionQueries(int node, const glm::vec3& camera)
+{
+    // Query hidden nodes (whose parents are visible) and visible leaves (returns number of queries)
+    // Visible leaves are re-checked every few frames, staggered so the queries spread over frames,
+    // and again the next frame after a hidden result to confirm it
+    OcclusionNode *n = &(app.occlusion_nodes[node]);
+    if (n->query_pending)
+    {
+        return 0;
+    }
+    bool camera_inside = glm::all(glm::greaterThanEqual(camera, n->bbox_min)) &&
+                         glm::all(glm::lessThanEqual(camera, n->bbox_max));
+    if (camera_inside)
+    {
+        // Box faces behind the near plane would be clipped, so assume the node is visible
+        if (!n->visible)
+        {
+            setOcclusionSubtreeVisible(node, true);
+        }
+        if (n->item >= 0)
+        {
+            return 0;
+        }
+    }
+    else if (!n->visible || (n->item >= 0 && ((app.frame_count + node) % OCCLUSION_VISIBLE_INTERVAL == 0 ||
+                                              n->hidden_results > 0)))
+    {
+        COUNT_GL(glUniform3fv(app.bbox_program->loc.bbox_min, 1, glm::value_ptr(n->bbox_min)));
+        COUNT_GL(glUniform3fv(app.bbox_program->loc.bbox_max, 1, glm::value_ptr(n->bbox_max)));
+        COUNT_GL(glBeginQuery(GL_SAMPLES_PASSED, n->query));
+        COUNT_GL(glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0));
+        COUNT_GL(glEndQuery(GL_SAMPLES_PASSED));
+        n->query_pending = true;
+        return 1;
+    }
+    if (n->item >= 0)
+    {
+        return 0;
+    }
+    int left = n->children[0];
+    int right = n->children[1];
+    return issueOcclusionQueries(left, camera) + issueOcclusionQueries(right, camera);
+}
+
+void createDeferredMaterials()
+{
+    // Flatten materials for untextured shading (textures contribute their average color)
+    int i;
+    int num_materials = app.material_table.size();
+    std::vector<float> materials(8 * num_materials);
+    for (i = 0; i < num_materials; i++)
+    {
+        const MaterialEntry& entry = app.material_table[i];
+        glm::vec3 color = glm::vec3(entry.color[0], entry.color[1], entry.color[2]);
+        if (entry.color[3] >= 0.0)
+        {
+            glm::vec4 average = app.material_averages[i];
+            color = ((1.0f - average.w) * color) + (average.w * glm::vec3(average));
+        }
+        materials[8 * i + 0] = color.x;
+        materials[8 * i + 1] = color.y;
+        materials[8 * i + 2] = color.z;
+        materials[8 * i + 3] = 1.0;
+        memcpy(materials.data() + 8 * i + 4, entry.specular, 4 * sizeof(float));
+    }
+
+    // Global material IDs: ranks' tables are concatenated in rank order on the display rank
+    int offset = 0, total = 0;
+    MPI_Exscan(&num_materials, &offset, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&num_materials, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    app.material_id_offset = (app.rank == 0) ? 0 : offset;
+    if (total > 65536)
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Error: %d materials exceed the 16-bit material IDs of deferred shading\n", total);
+        }
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    int num_floats = 8 * num_materials;
+    std::vector<int> counts(app.num_proc), displacements(app.num_proc);
+    MPI_Gather(&num_floats, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    for (i = 0; i < app.num_proc; i++)
+    {
+        displacements[i] = (i == 0) ? 0 : displacements[i - 1] + counts[i - 1];
+    }
+    std::vector<float> global_materials(app.rank == 0 ? 8 * total : 0);
+    MPI_Gatherv(materials.data(), num_floats, MPI_FLOAT, global_materials.data(), counts.data(),
+                displacements.data(), MPI_FLOAT, 0, MPI_COMM_WORLD);
+
+    // Display rank looks materials up from a buffer texture (two RGBA texels per material)
+    if (app.rank == 0)
+    {
+        glGenBuffers(1, &(app.deferred_material_buffer));
+        glBindBuffer(GL_TEXTURE_BUFFER, app.deferred_material_buffer);
+        glBufferData(GL_TEXTURE_BUFFER, global_materials.size() * sizeof(float), global_materials.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        glGenTextures(1, &(app.deferred_material_texture));
+        glBindTexture(GL_TEXTURE_BUFFER, app.deferred_material_texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, app.deferred_material_buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+}
+
+void drawDeferredLighting(const float mat4_projection[16], const float mat4_modelview[16])
+{
+    // Full-screen lighting pass over the composited G-buffer (plane vertex array must be bound)
+    glUseProgram(app.deferred_program->program);
+    glUniformMatrix4fv(app.deferred_program->loc.projection_matrix, 1, GL_FALSE, mat4_projection);
+    glUniformMatrix4fv(app.deferred_program->loc.modelview_matrix, 1, GL_FALSE, mat4_modelview);
+
+    // Composited depth maps back to NDC z of the projection it was rendered with
+    glm::dmat4 view_projection = app.projection_matrix * app.view_matrix;
+    float depth_to_ndc[2] = {2.0, -1.0};
+#ifndef USE_ICET_OGL3
+    if (app.reverse_z)
+    {
+        // Negated reverse-Z depth (see renderIceTGeneric), kept at full precision
+        view_projection = app.reverse_z_matrix * view_projection;
+        depth_to_ndc[0] = (app.clip_control != NULL) ? -1.0 : -2.0;
+        depth_to_ndc[1] = (app.clip_control != NULL) ? 0.0 : -1.0;
+    }
+#endif
+    float mat4_inverse_vp[16];
+    mat4ToFloatArray(glm::inverse(view_projection), mat4_inverse_vp);
+    glUniformMatrix4fv(app.deferred_program->loc.inverse_view_projection, 1, GL_FALSE, mat4_inverse_vp);
+    glUniform2fv(app.deferred_program->loc.depth_to_ndc, 1, depth_to_ndc);
+    glUniform3fv(app.deferred_program->loc.camera_position, 1, glm::value_ptr(app.camera_position));
+    float background[4] = {(float)app.background_color[0], (float)app.background_color[1],
+                           (float)app.background_color[2], (float)app.background_color[3]};
+    glUniform4fv(app.deferred_program->loc.background_color, 1, background);
+
+    // G-buffer is already in the composite texture (unit 0)
+    glUniform1i(app.deferred_program->loc.image, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, app.composite_depth_texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, app.window_width, app.window_height, GL_RED, GL_FLOAT,
+                    icetImageGetDepthf(app.image));
+    glUniform1i(app.deferred_program->loc.depth_buffer, 1);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_BUFFER, app.deferred_material_texture);
+    glUniform1i(app.deferred_program->loc.material_table, 2);
+    glActiveTexture(GL_TEXTURE0);
+
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+
+    glUseProgram(app.nolight_program->program);
+}
+
+void computeTileLayout()
+{
+    // Pick the rows x columns grid (rows * columns = num_proc) with the most square tiles
+    int rows = 1, columns = app.num_proc;
+    double best_aspect = 9.9e12;
+    int r;
+    for (r = 1; r <= app.num_proc; r++)
+    {
+        if (app.num_proc % r != 0) continue;
+        int c = app.num_proc / r;
+        double tile_aspect = ((double)app.window_width / (double)c) / ((double)app.window_height / (double)r);
+        double aspect_error = (tile_aspect > 1.0) ? tile_aspect : 1.0 / tile_aspect;
+        if (aspect_error < best_aspect)
+        {
+            best_aspect = aspect_error;
+            rows = r;
+            columns = c;
+        }
+    }
+
+    // Tile viewports (x, y, width, height) - rank i displays tile i
+    app.tile_viewports.resize(4 * app.num_proc);
+    int i;
+    for (i = 0; i < app.num_proc; i++)
+    {
+        int row = i / columns;
+        int column = i % columns;
+        int x0 = (column * app.window_width) / columns;
+        int x1 = ((column + 1) * app.window_width) / columns;
+        int y0 = (row * app.window_height) / rows;
+        int y1 = ((row + 1) * app.window_height) / rows;
+        app.tile_viewports[4 * i + 0] = x0;
+        app.tile_viewports[4 * i + 1] = y0;
+        app.tile_viewports[4 * i + 2] = x1 - x0;
+        app.tile_viewports[4 * i + 3] = y1 - y0;
+    }
+
+    if (app.rank == 0)
+    {
+        printf("Sort-first: %dx%d tiles (max %dx%d pixels)\n", columns, rows,
+               (app.window_width + columns - 1) / columns, (app.window_height + rows - 1) / rows);
+    }
+}
+
+void gatherTiles()
+{
+    double start = MPI_Wtime();
+
+    int i, row;
+    int tile_width = app.tile_viewports[4 * app.rank + 2];
+    int tile_height = app.tile_viewports[4 * app.rank + 3];
+    IceTUByte *tile_pixels = icetImageGetColorub(app.image);
+
+    std::vector<int> counts, displacements;
+    std::vector<IceTUByte> tiles;
+    if (app.rank == 0)
+    {
+        counts.resize(app.num_proc);
+        displacements.resize(app.num_proc);
+        int offset = 0;
+        for (i = 0; i < app.num_proc; i++)
+        {
+            counts[i] = 4 * app.tile_viewports[4 * i + 2] * app.tile_viewports[4 * i + 3];
+            displacements[i] = offset;
+            offset += counts[i];
+        }
+        tiles.resize(offset);
+    }
+    MPI_Gatherv(tile_pixels, 4 * tile_width * tile_height, MPI_UNSIGNED_CHAR, tiles.data(), counts.data(),
+                displacements.data(), MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+
+    // Copy tiles row by row into the full frame
+    if (app.rank == 0)
+    {
+        for (i = 0; i < app.num_proc; i++)
+        {
+            int x = app.tile_viewports[4 * i + 0];
+            int y = app.tile_viewports[4 * i + 1];
+            int w = app.tile_viewports[4 * i + 2];
+            int h = app.tile_viewports[4 * i + 3];
+            for (row = 0; row < h; row++)
+            {
+                memcpy(app.frame_pixels.data() + 4 * ((y + row) * app.window_width + x),
+                       tiles.data() + displacements[i] + 4 * row * w, 4 * w);
+            }
+        }
+    }
+
+    app.tile_gather_time += MPI_Wtime() - start;
+}
+
 void mat4ToFloatArray(glm::dmat4 mat4, float array[16])
 {
     array[0] = mat4[0][0];
@@ -782,43 +2631,86 @@ void mat4ToFloatArray(glm::dmat4 mat4, float array[16])
     array[15] = mat4[3][3];
 }
 
-void mat3ToFloatArray(glm::dmat3 mat3, float array[9])
+void mat3ToStd140Array(glm::dmat3 mat3, float array[12])
 {
     array[0] = mat3[0][0];
     array[1] = mat3[0][1];
     array[2] = mat3[0][2];
-    array[3] = mat3[1][0];
-    array[4] = mat3[1][1];
-    array[5] = mat3[1][2];
-    array[6] = mat3[2][0];
-    array[7] = mat3[2][1];
-    array[8] = mat3[2][2];
+    array[3] = 0.0;
+    array[4] = mat3[1][0];
+    array[5] = mat3[1][1];
+    array[6] = mat3[1][2];
+    array[7] = 0.0;
+    array[8] = mat3[2][0];
+    array[9] = mat3[2][1];
+    array[10] = mat3[2][2];
+    array[11] = 0.0;
 }
 
-void loadShader(std::string key, std::string shader_filename_base)
+void loadShader(std::string key, std::string shader_filename_base, const char *defines)
 {
     // Compile GPU program
     GlslProgram p;
     std::string vert_filename = shader_filename_base + ".vert";
     std::string frag_filename = shader_filename_base + ".frag";
-    p.program = glsl::createShaderProgram(vert_filename.c_str(), frag_filename.c_str());
+    p.program = glsl::createShaderProgram(vert_filename.c_str(), frag_filename.c_str(), defines);
 
     // Specify input and output attributes for the GPU program
     glBindAttribLocation(p.program, app.vertex_position_attrib, "vertex_position");
     glBindAttribLocation(p.program, app.vertex_normal_attrib, "vertex_normal");
     glBindAttribLocation(p.program, app.vertex_texcoord_attrib, "vertex_texcoord");
+    glBindAttribLocation(p.program, app.vertex_material_attrib, "vertex_material");
     glBindFragDataLocation(p.program, 0, "FragColor");
 
     // Link compiled GPU program
     glsl::linkShaderProgram(p.program);
 
+    // Attach shared uniform blocks to their binding points
+    bindUniformBlock(p.program, "Transforms", TRANSFORM_BLOCK_BINDING);
+    bindUniformBlock(p.program, "Lights", LIGHT_BLOCK_BINDING);
+    bindUniformBlock(p.program, "Materials", MATERIAL_BLOCK_BINDING);
+
     // Get handles to uniform variables defined in the shaders
     glsl::getShaderProgramUniforms(p.program, p.uniforms);
+    resolveUniformLocations(&p);
 
     // Store GPU program and uniforms
     app.glsl_program[key] = p;
 }
 
+void resolveUniformLocations(GlslProgram *p)
+{
+    p->loc.projection_matrix = findUniform(p, "projection_matrix");
+    p->loc.modelview_matrix = findUniform(p, "modelview_matrix");
+    p->loc.image = findUniform(p, "image");
+    p->loc.font_color = findUniform(p, "font_color");
+    p->loc.material_base = findUniform(p, "material_base");
+    p->loc.depth_buffer = findUniform(p, "depth_buffer");
+    p->loc.material_table = findUniform(p, "material_table");
+    p->loc.inverse_view_projection = findUniform(p, "inverse_view_projection");
+    p->loc.depth_to_ndc = findUniform(p, "depth_to_ndc");
+    p->loc.camera_position = findUniform(p, "camera_position");
+    p->loc.background_color = findUniform(p, "background_color");
+    p->loc.object_id = findUniform(p, "object_id");
+    p->loc.bbox_min = findUniform(p, "bbox_min");
+    p->loc.bbox_max = findUniform(p, "bbox_max");
+}
+
+GLint findUniform(GlslProgram *p, const char *name)
+{
+    std::map<std::string,GLint>::iterator it = p->uniforms.find(name);
+    return (it != p->uniforms.end()) ? it->second : -1;
+}
+
+void bindUniformBlock(GLuint program, const char *name, GLuint binding)
+{
+    GLuint block_index = glGetUniformBlockIndex(program, name);
+    if (block_index != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(program, block_index, binding);
+    }
+}
+
 void loadObjModels(std::string model_path, float bbox[6])
 {
     bbox[0] =  9.9e12; // x min
@@ -829,9 +2721,12 @@ void loadObjModels(std::string model_path, float bbox[6])
     bbox[5] = -9.9e12; // z max
     std::vector<std::string> obj_filenames = directory::listFiles(model_path, "obj");
     
+    // Sort-first replicates every model on every rank
     int i;
+    int start = app.sort_first ? 0 : app.rank;
+    int stride = app.sort_first ? 1 : app.num_proc;
     uint32_t total_triangles = 0;
-    for (i = app.rank; i < obj_filenames.size(); i += app.num_proc)
+    for (i = start; i < obj_filenames.size(); i += stride)
     {
         std::string obj_path = model_path + "/" + obj_filenames[i];
         ObjLoader *model = new ObjLoader(obj_path.c_str());
@@ -936,3 +2831,44 @@ void writePpm(const char *filename, int width, int height, const uint8_t *rgba)
 
     fclose(fp);
 }
+
+GLuint boxVertexArray()
+{
+    // Unit cube (scaled to a bounding box in bbox.vert)
+    GLuint vertex_array;
+    glGenVertexArrays(1, &vertex_array);
+    glBindVertexArray(vertex_array);
+
+    // Vertex positions
+    GLuint vertex_position_buffer;
+    glGenBuffers(1, &vertex_position_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_position_buffer);
+    GLfloat vertices[24] = {
+        0.0, 0.0, 0.0,
+        1.0, 0.0, 0.0,
+        1.0, 1.0, 0.0,
+        0.0, 1.0, 0.0,
+        0.0, 0.0, 1.0,
+        1.0, 0.0, 1.0,
+        1.0, 1.0, 1.0,
+        0.0, 1.0, 1.0
+    };
+    glBufferData(GL_ARRAY_BUFFER, 24 * sizeof(GLfloat), vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(app.vertex_position_attrib);
+    glVertexAttribPointer(app.vertex_position_attrib, 3, GL_FLOAT, false, 0, 0);
+
+    // Faces of the triangles
+    GLuint vertex_index_buffer;
+    glGenBuffers(1, &vertex_index_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vertex_index_buffer);
+    GLushort indices[36] = {
+        0, 2, 1,    0, 3, 2,    4, 5, 6,    4, 6, 7,
+        0, 1, 5,    0, 5, 4,    3, 7, 6,    3, 6, 2,
+        0, 4, 7,    0, 7, 3,    1, 2, 6,    1, 6, 5
+    };
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 36 * sizeof(GLushort), indices, GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+
+    return vertex_array;
+}
@@ -1,12 +1,14 @@
+#include <cstring>
 #include "glslloader.h"
 
+static int32_t injectDefines(char **source_ptr, int32_t length, const char *defines);
 static GLint compileShader(char *source, int32_t length, GLenum type);
 static GLuint attachShaders(GLuint shaders[], uint16_t num_shaders);
 static std::string shaderTypeToString(GLenum type);
 static int32_t readFile(const char* filename, char** data_ptr);
 
 // Public
-GLuint glsl::createShaderProgram(const char *vert_filename, const char *frag_filename)
+GLuint glsl::createShaderProgram(const char *vert_filename, const char *frag_filename, const char *defines)
 {
     // Read vertex and fragment shaders from file
     char *vert_source, *frag_source;
@@ -17,6 +19,13 @@ GLuint glsl::createShaderProgram(const char *vert_filename, const char *frag_fil
         return 0;
     }
 
+    // Specialize shaders with preprocessor definitions (e.g. "#define NUM_LIGHTS 1\n")
+    if (defines != NULL && defines[0] != '\0')
+    {
+        vert_length = injectDefines(&vert_source, vert_length, defines);
+        frag_length = injectDefines(&frag_source, frag_length, defines);
+    }
+
     // Compile vetex shader
     GLuint vertex_shader = compileShader(vert_source, vert_length, GL_VERTEX_SHADER);
     // Compile fragment shader
@@ -69,6 +78,30 @@ void glsl::getShaderProgramUniforms(GLuint program, std::map<std::string,GLint>&
 
 
 // Private
+int32_t injectDefines(char **source_ptr, int32_t length, const char *defines)
+{
+    // Definitions go right after the #version line, which must stay first
+    std::string source(*source_ptr, length);
+    size_t insert_pos = 0;
+    if (source.compare(0, 8, "#version") == 0)
+    {
+        size_t newline = source.find('\n');
+        insert_pos = (newline == std::string::npos) ? source.length() : newline + 1;
+        if (newline == std::string::npos)
+        {
+            source += "\n";
+            insert_pos++;
+        }
+    }
+    source.insert(insert_pos, defines);
+
+    free(*source_ptr);
+    *source_ptr = (char*)malloc(source.length());
+    memcpy(*source_ptr, source.data(), source.length());
+
+    return source.length();
+}
+
 GLint compileShader(char *source, int32_t length, GLenum type)
 {
     // Create a shader object
@@ -1,5 +1,8 @@
+#include <cmath>
 #include "objloader.h"
 
+std::map<std::string, CachedTexture> ObjLoader::_texture_cache;
+
 ObjLoader::ObjLoader(const char *filename)
 {
     _position_attrib = 0;
@@ -178,6 +181,9 @@ unsigned int ObjLoader::createModels(std::vector<glm::vec3> &vertices,
     {
         Model model;
         model.material_name = groups[i].material_name;
+        model.vertex_texcoord_buffer = 0;
+        model.bbox_min = glm::vec3(1.0e12, 1.0e12, 1.0e12);
+        model.bbox_max = glm::vec3(-1.0e12, -1.0e12, -1.0e12);
 
         GLuint num_faces = groups[i].faces.size();
         GLuint num_verts = num_faces * 3;
@@ -200,6 +206,8 @@ unsigned int ObjLoader::createModels(std::vector<glm::vec3> &vertices,
                 model_vertices[vn_idx] = vertex.x;
                 model_vertices[vn_idx + 1] = vertex.y;
                 model_vertices[vn_idx + 2] = vertex.z;
+                model.bbox_min = glm::min(model.bbox_min, vertex);
+                model.bbox_max = glm::max(model.bbox_max, vertex);
 
                 glm::vec3 normal = normals[groups[i].faces[j].normal_indices[k]];
                 model_normals[vn_idx] = normal.x;
@@ -229,6 +237,7 @@ unsigned int ObjLoader::createModels(std::vector<glm::vec3> &vertices,
         // Create buffer to store vertex positions (3D points)
         GLuint vertex_position_buffer;
         glGenBuffers(1, &vertex_position_buffer);
+        model.vertex_position_buffer = vertex_position_buffer;
         // Set newly created buffer as the active one we are modifying
         glBindBuffer(GL_ARRAY_BUFFER, vertex_position_buffer);
         // Store array of vertex positions in the vertex_position_buffer
@@ -242,6 +251,7 @@ unsigned int ObjLoader::createModels(std::vector<glm::vec3> &vertices,
         // Create buffer to store vertex normals (vector pointing perpendicular to surface)
         GLuint vertex_normal_buffer;
         glGenBuffers(1, &vertex_normal_buffer);
+        model.vertex_normal_buffer = vertex_normal_buffer;
         // Set newly created buffer as the active one we are modifying
         glBindBuffer(GL_ARRAY_BUFFER, vertex_normal_buffer);
         // Store array of vertex normals in the vertex_normal_buffer
@@ -257,6 +267,7 @@ unsigned int ObjLoader::createModels(std::vector<glm::vec3> &vertices,
             // Create buffer to store texture coordinates (2D coordinates for mapping images to the surface)
             GLuint vertex_texcoord_buffer;
             glGenBuffers(1, &vertex_texcoord_buffer);
+            model.vertex_texcoord_buffer = vertex_texcoord_buffer;
             // Set newly created buffer as the active one we are modifying
             glBindBuffer(GL_ARRAY_BUFFER, vertex_texcoord_buffer);
             // Store array of vertex texture coordinates in the vertex_texcoord_buffer
@@ -271,6 +282,7 @@ unsigned int ObjLoader::createModels(std::vector<glm::vec3> &vertices,
         // Create buffer to store faces of the triangle
         GLuint vertex_index_buffer;
         glGenBuffers(1, &vertex_index_buffer);
+        model.vertex_index_buffer = vertex_index_buffer;
         // Set newly created buffer as the active one we are modifying
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vertex_index_buffer);
         // Store array of vertex indices in the vertex_index_buffer
@@ -351,13 +363,23 @@ void ObjLoader::loadMtl(const char *filename)
                 img_path = mtl_filename.substr(0, pos + 1);
             }
             _materials[current_material].has_texture = true;
-            createMaterialTexture((img_path + img_filename).c_str(), &(_materials[current_material].texture_id));
+            createMaterialTexture((img_path + img_filename).c_str(), &(_materials[current_material].texture_id),
+                                  &(_materials[current_material].texture_average));
         }
     }
 }
 
-void ObjLoader::createMaterialTexture(const char *filename, GLuint *texture_id)
+void ObjLoader::createMaterialTexture(const char *filename, GLuint *texture_id, glm::vec4 *average_color)
 {
+    // Share textures between models that reference the same image file
+    std::map<std::string, CachedTexture>::iterator cached = _texture_cache.find(filename);
+    if (cached != _texture_cache.end())
+    {
+        *texture_id = cached->second.texture_id;
+        *average_color = cached->second.average_color;
+        return;
+    }
+
     glGenTextures(1, texture_id);
     glBindTexture(GL_TEXTURE_2D, *texture_id);
 
@@ -376,7 +398,31 @@ void ObjLoader::createMaterialTexture(const char *filename, GLuint *texture_id)
 
     glBindTexture(GL_TEXTURE_2D, 0);
 
+    // Average color (for shading without texture coordinates), decoded from sRGB
+    int i;
+    double srgb_to_linear[256];
+    for (i = 0; i < 256; i++)
+    {
+        double c = i / 255.0;
+        srgb_to_linear[i] = (c <= 0.04045) ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+    }
+    double sum[4] = {0.0, 0.0, 0.0, 0.0};
+    for (i = 0; i < width * height; i++)
+    {
+        sum[0] += srgb_to_linear[pixels[4 * i]];
+        sum[1] += srgb_to_linear[pixels[4 * i + 1]];
+        sum[2] += srgb_to_linear[pixels[4 * i + 2]];
+        sum[3] += pixels[4 * i + 3] / 255.0;
+    }
+    double num_pixels = (width * height > 0) ? width * height : 1;
+    *average_color = glm::vec4(sum[0] / num_pixels, sum[1] / num_pixels, sum[2] / num_pixels, sum[3] / num_pixels);
+
     freeRgba(pixels);
+
+    CachedTexture texture;
+    texture.texture_id = *texture_id;
+    texture.average_color = *average_color;
+    _texture_cache[filename] = texture;
 }
 
 std::vector<Model>& ObjLoader::getModelList()
@@ -384,6 +430,53 @@ std::vector<Model>& ObjLoader::getModelList()
     return _models;
 }
 
+void ObjLoader::releaseModelBuffers()
+{
+    // Free per-group GPU buffers (e.g. once they have been copied into shared batches)
+    int i;
+    for (i = 0; i < _models.size(); i++)
+    {
+        GLuint buffers[4] = {_models[i].vertex_position_buffer, _models[i].vertex_normal_buffer,
+                             _models[i].vertex_texcoord_buffer, _models[i].vertex_index_buffer};
+        glDeleteBuffers(4, buffers);
+        glDeleteVertexArrays(1, &(_models[i].vertex_array));
+        _models[i].vertex_array = 0;
+        _models[i].vertex_position_buffer = 0;
+        _models[i].vertex_normal_buffer = 0;
+        _models[i].vertex_texcoord_buffer = 0;
+        _models[i].vertex_index_buffer = 0;
+    }
+}
+
+void ObjLoader::releaseTextures()
+{
+    // Free material textures (e.g. once they have been copied into texture arrays)
+    // The cache owns each texture, so shared textures are deleted once and never handed out again
+    std::map<std::string, Material>::iterator mat;
+    std::map<std::string, CachedTexture>::iterator cached;
+    for (mat = _materials.begin(); mat != _materials.end(); mat++)
+    {
+        if (mat->second.texture_id == 0)
+        {
+            continue;
+        }
+        cached = _texture_cache.begin();
+        while (cached != _texture_cache.end())
+        {
+            if (cached->second.texture_id == mat->second.texture_id)
+            {
+                glDeleteTextures(1, &(cached->second.texture_id));
+                _texture_cache.erase(cached++);
+            }
+            else
+            {
+                cached++;
+            }
+        }
+        mat->second.texture_id = 0;
+    }
+}
+
 Material& ObjLoader::getMaterial(std::string name)
 {
     return _materials[name];
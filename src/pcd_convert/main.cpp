@@ -0,0 +1,193 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "pcdfile.h"
+
+// Convert a text header .pcd point cloud to the chunked binary format (see pcdfile.h)
+
+#define DEFAULT_CHUNK_SIZE 65536
+
+uint64_t readHeader(std::ifstream &in_file, PcdHeader *header);
+void readSection(std::ifstream &in_file, uint64_t offset, float *buffer, uint64_t count);
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <input.pcd> <output.pcd> [--chunk-size N]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    uint64_t chunk_size = DEFAULT_CHUNK_SIZE;
+    int i = 3;
+    while (i < argc)
+    {
+        std::string argument = argv[i];
+        if (argument == "--chunk-size" && i < argc - 1)
+        {
+            chunk_size = std::stoull(argv[i + 1]);
+            i += 2;
+        }
+        else
+        {
+            i += 1;
+        }
+    }
+    if (chunk_size == 0 || chunk_size > PCD_MAX_CHUNK_POINTS)
+    {
+        fprintf(stderr, "Error: chunk size must be between 1 and %d\n", PCD_MAX_CHUNK_POINTS);
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream in_file(argv[1], std::ios::binary);
+    if (!in_file.is_open())
+    {
+        fprintf(stderr, "Error: could not open input file %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    std::ofstream out_file(argv[2], std::ios::binary);
+    if (!out_file.is_open())
+    {
+        fprintf(stderr, "Error: could not open output file %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    // Header and chunk table
+    PcdHeader header;
+    uint64_t data_offset = readHeader(in_file, &header);
+    uint64_t num_points = header.num_points;
+    header.num_chunks = (num_points + chunk_size - 1) / chunk_size;
+    std::vector<PcdChunk> chunks(header.num_chunks);
+    uint64_t offset = sizeof(PcdHeader) + header.num_chunks * sizeof(PcdChunk);
+
+    // Copy one chunk at a time (centers, colors, sizes of the chunk are stored together)
+    uint64_t c, j;
+    int axis;
+    std::vector<float> centers(3 * chunk_size);
+    std::vector<float> colors(3 * chunk_size);
+    std::vector<float> sizes(chunk_size);
+    out_file.seekp(offset);
+    for (c = 0; c < header.num_chunks; c++)
+    {
+        uint64_t first = c * chunk_size;
+        uint64_t count = std::min(chunk_size, num_points - first);
+        readSection(in_file, data_offset + 3 * first * sizeof(float), centers.data(), 3 * count);
+        readSection(in_file, data_offset + 3 * (num_points + first) * sizeof(float), colors.data(), 3 * count);
+        readSection(in_file, data_offset + (6 * num_points + first) * sizeof(float), sizes.data(), count);
+
+        chunks[c].num_points = count;
+        chunks[c].offset = offset;
+        for (axis = 0; axis < 3; axis++)
+        {
+            chunks[c].bbox_min[axis] = centers[axis];
+            chunks[c].bbox_max[axis] = centers[axis];
+        }
+        for (j = 1; j < count; j++)
+        {
+            for (axis = 0; axis < 3; axis++)
+            {
+                chunks[c].bbox_min[axis] = std::min(chunks[c].bbox_min[axis], centers[3 * j + axis]);
+                chunks[c].bbox_max[axis] = std::max(chunks[c].bbox_max[axis], centers[3 * j + axis]);
+            }
+        }
+
+        out_file.write((char*)centers.data(), 3 * count * sizeof(float));
+        out_file.write((char*)colors.data(), 3 * count * sizeof(float));
+        out_file.write((char*)sizes.data(), count * sizeof(float));
+        offset += 7 * count * sizeof(float);
+    }
+
+    out_file.seekp(0);
+    out_file.write((char*)&header, sizeof(PcdHeader));
+    out_file.write((char*)chunks.data(), header.num_chunks * sizeof(PcdChunk));
+    if (!out_file.good())
+    {
+        fprintf(stderr, "Error: could not write output file %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+    out_file.close();
+    in_file.close();
+
+    printf("Converted %llu points into %llu chunks\n", (unsigned long long)num_points,
+           (unsigned long long)header.num_chunks);
+
+    return 0;
+}
+
+uint64_t readHeader(std::ifstream &in_file, PcdHeader *header)
+{
+    // Text header: camera, lights, and point count (binary point data follows)
+    const int CAMERA_POSITION = 0;
+    const int CAMERA_TARGET = 1;
+    const int LIGHT_COUNT = 2;
+    const int LIGHTS = 3;
+    const int POINT_COUNT = 4;
+    const int POINTS = 5;
+
+    memset(header, 0, sizeof(PcdHeader));
+    memcpy(header->magic, PCD_MAGIC, 4);
+    header->version = PCD_VERSION;
+
+    std::string line;
+    int section = CAMERA_POSITION;
+    uint32_t light_idx = 0;
+    while (section != POINTS)
+    {
+        if (!std::getline(in_file, line))
+        {
+            fprintf(stderr, "Error: incomplete point cloud header\n");
+            exit(EXIT_FAILURE);
+        }
+        std::istringstream iss(line);
+        PcdLight *light;
+        switch (section)
+        {
+            case CAMERA_POSITION:
+                iss >> header->camera_position[0] >> header->camera_position[1] >> header->camera_position[2];
+                section = CAMERA_TARGET;
+                break;
+            case CAMERA_TARGET:
+                iss >> header->camera_target[0] >> header->camera_target[1] >> header->camera_target[2];
+                section = LIGHT_COUNT;
+                break;
+            case LIGHT_COUNT:
+                iss >> header->num_lights;
+                if (header->num_lights > PCD_MAX_LIGHTS)
+                {
+                    fprintf(stderr, "Error: at most %d lights are supported\n", PCD_MAX_LIGHTS);
+                    exit(EXIT_FAILURE);
+                }
+                section = (header->num_lights > 0) ? LIGHTS : POINT_COUNT;
+                break;
+            case LIGHTS:
+                light = &(header->lights[light_idx]);
+                iss >> light->position[0] >> light->position[1] >> light->position[2] >>
+                       light->color[0] >> light->color[1] >> light->color[2];
+                light_idx++;
+                if (light_idx >= header->num_lights)
+                {
+                    section = POINT_COUNT;
+                }
+                break;
+            case POINT_COUNT:
+                iss >> header->num_points;
+                section = POINTS;
+                break;
+        }
+    }
+    return in_file.tellg();
+}
+
+void readSection(std::ifstream &in_file, uint64_t offset, float *buffer, uint64_t count)
+{
+    in_file.seekg(offset);
+    in_file.read((char*)buffer, count * sizeof(float));
+    if (!in_file.good())
+    {
+        fprintf(stderr, "Error: input file is shorter than its header describes\n");
+        exit(EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,368 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <mpi.h>
+#include "pcdfile.h"
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+// Generate a synthetic GPS-like globe in the chunked binary format (see pcdfile.h)
+//
+// Points are grouped into clusters on a unit sphere (cities), with part of each
+// cluster stretched along a random direction (tracks), plus uniform background
+// noise. Clusters own consecutive runs of points, so file order chunks stay
+// spatially compact. Each chunk is generated from its own seed, so the output
+// does not depend on the number of ranks writing it.
+
+#define DEFAULT_NUM_POINTS 1000000
+#define DEFAULT_CHUNK_SIZE 65536
+#define DEFAULT_NUM_CLUSTERS 512
+#define BACKGROUND_FRACTION 0.05  // points spread uniformly over the globe
+#define TRACK_FRACTION 0.3        // cluster points stretched along a track
+#define GLOBE_RADIUS 1.0f
+
+typedef struct Cluster {
+    float center[3];
+    float tangent[3];             // track direction
+    float bitangent[3];
+    float spread;                 // angular standard deviation (radians)
+    uint64_t first;               // first point of the cluster's run
+} Cluster;
+
+uint64_t parseCount(const char *value);
+void createClusters(uint32_t num_clusters, uint64_t num_points, uint64_t seed, std::vector<Cluster> &clusters);
+void generateChunk(const std::vector<Cluster> &clusters, uint64_t seed, uint64_t chunk_idx, uint64_t first,
+                   uint64_t count, float *data, PcdChunk *chunk);
+void setPoint(float *center, const float direction[3], float altitude);
+
+int main(int argc, char **argv)
+{
+    // Initialize MPI
+    int rank, num_proc;
+    int rc = MPI_Init(&argc, &argv);
+    rc |= MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    rc |= MPI_Comm_size(MPI_COMM_WORLD, &num_proc);
+    if (rc != 0)
+    {
+        fprintf(stderr, "Error initializing MPI\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    if (argc < 2)
+    {
+        if (rank == 0)
+        {
+            fprintf(stderr, "Usage: %s <output.pcd> [--points N (e.g. 1M to 1B)] [--chunk-size N] [--clusters N] [--seed N]\n", argv[0]);
+        }
+        MPI_Finalize();
+        return EXIT_FAILURE;
+    }
+    uint64_t num_points = DEFAULT_NUM_POINTS;
+    uint64_t chunk_size = DEFAULT_CHUNK_SIZE;
+    uint32_t num_clusters = DEFAULT_NUM_CLUSTERS;
+    uint64_t seed = 2012;
+    int i = 2;
+    while (i < argc)
+    {
+        std::string argument = argv[i];
+        if (argument == "--points" && i < argc - 1)
+        {
+            num_points = parseCount(argv[i + 1]);
+            i += 2;
+        }
+        else if (argument == "--chunk-size" && i < argc - 1)
+        {
+            chunk_size = parseCount(argv[i + 1]);
+            i += 2;
+        }
+        else if (argument == "--clusters" && i < argc - 1)
+        {
+            num_clusters = std::stoul(argv[i + 1]);
+            i += 2;
+        }
+        else if (argument == "--seed" && i < argc - 1)
+        {
+            seed = std::stoull(argv[i + 1]);
+            i += 2;
+        }
+        else
+        {
+            i += 1;
+        }
+    }
+    if (num_points == 0 || num_clusters == 0)
+    {
+        fprintf(stderr, "Error: point and cluster counts must be positive\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    if (chunk_size == 0 || chunk_size > PCD_MAX_CHUNK_POINTS)
+    {
+        fprintf(stderr, "Error: chunk size must be between 1 and %d\n", PCD_MAX_CHUNK_POINTS);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // Header: camera looking at the globe from +z (fills the default 60 degree view), key and fill lights
+    PcdHeader header;
+    memset(&header, 0, sizeof(PcdHeader));
+    memcpy(header.magic, PCD_MAGIC, 4);
+    header.version = PCD_VERSION;
+    header.num_points = num_points;
+    header.num_chunks = (num_points + chunk_size - 1) / chunk_size;
+    header.camera_position[2] = 2.4f * GLOBE_RADIUS;
+    header.num_lights = 2;
+    float lights[2][6] = {{4.0f, 3.0f, 6.0f, 1.0f, 0.96f, 0.9f},
+                          {-6.0f, -1.0f, 2.0f, 0.25f, 0.3f, 0.4f}};
+    for (i = 0; i < header.num_lights; i++)
+    {
+        memcpy(header.lights[i].position, lights[i], 3 * sizeof(float));
+        memcpy(header.lights[i].color, lights[i] + 3, 3 * sizeof(float));
+    }
+
+    // Every rank builds the same clusters, then generates a contiguous range of chunks
+    std::vector<Cluster> clusters;
+    createClusters(num_clusters, num_points, seed, clusters);
+    uint64_t chunk_start = header.num_chunks * rank / num_proc;
+    uint64_t chunk_end = header.num_chunks * (rank + 1) / num_proc;
+    if ((chunk_end - chunk_start) * sizeof(PcdChunk) > INT_MAX)
+    {
+        fprintf(stderr, "Error: too many chunks per rank (increase --chunk-size)\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    MPI_File file;
+    if (rank == 0)
+    {
+        MPI_File_delete(argv[1], MPI_INFO_NULL);  // ignore failure (no previous file)
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (MPI_File_open(MPI_COMM_WORLD, argv[1], MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+    {
+        fprintf(stderr, "Error: could not open output file %s\n", argv[1]);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+
+    // Stream one chunk at a time (centers, colors, sizes of the chunk are stored together)
+    uint64_t c;
+    uint64_t table_offset = sizeof(PcdHeader);
+    uint64_t data_offset = table_offset + header.num_chunks * sizeof(PcdChunk);
+    std::vector<PcdChunk> chunks(chunk_end - chunk_start);
+    std::vector<float> data(7 * chunk_size);
+    rc = 0;
+    for (c = chunk_start; c < chunk_end; c++)
+    {
+        uint64_t first = c * chunk_size;
+        uint64_t count = std::min(chunk_size, num_points - first);
+        PcdChunk *chunk = &(chunks[c - chunk_start]);
+        generateChunk(clusters, seed, c, first, count, data.data(), chunk);
+        chunk->offset = data_offset + 7 * first * sizeof(float);
+        rc |= MPI_File_write_at(file, chunk->offset, data.data(), 7 * count, MPI_FLOAT, MPI_STATUS_IGNORE);
+    }
+    if (chunk_end > chunk_start)
+    {
+        rc |= MPI_File_write_at(file, table_offset + chunk_start * sizeof(PcdChunk), chunks.data(),
+                                chunks.size() * sizeof(PcdChunk), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    if (rank == 0)
+    {
+        rc |= MPI_File_write_at(file, 0, &header, sizeof(PcdHeader), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    if (rc != MPI_SUCCESS)
+    {
+        fprintf(stderr, "Error: could not write output file %s\n", argv[1]);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    MPI_File_close(&file);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double elapsed = MPI_Wtime() - start;
+
+    if (rank == 0)
+    {
+        double file_mb = (data_offset + 7 * num_points * sizeof(float)) / (1024.0 * 1024.0);
+        printf("Generated %llu points in %llu chunks (%.3lf MB) in %.3lf sec (%.3lf MB/s on %d ranks)\n",
+               (unsigned long long)num_points, (unsigned long long)header.num_chunks, file_mb, elapsed,
+               file_mb / elapsed, num_proc);
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
+
+uint64_t parseCount(const char *value)
+{
+    // Plain count, or with a K, M, or B suffix (e.g. 250M)
+    std::string count = value;
+    double scale = 1.0;
+    char suffix = count.empty() ? '\0' : toupper(count.back());
+    if (suffix == 'K' || suffix == 'M' || suffix == 'B')
+    {
+        scale = (suffix == 'K') ? 1.0e3 : ((suffix == 'M') ? 1.0e6 : 1.0e9);
+        count.pop_back();
+    }
+    return (uint64_t)(std::stod(count) * scale + 0.5);
+}
+
+void createClusters(uint32_t num_clusters, uint64_t num_points, uint64_t seed, std::vector<Cluster> &clusters)
+{
+    // Power law cluster populations (a few dense cities, many small towns) away from the poles
+    uint32_t k;
+    int axis;
+    std::mt19937_64 random(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<double> weights(num_clusters);
+    double total_weight = 0.0;
+    for (k = 0; k < num_clusters; k++)
+    {
+        weights[k] = 1.0 / pow(k + 1.0, 1.1);
+        total_weight += weights[k];
+    }
+
+    std::vector<Cluster> unordered(num_clusters);
+    std::vector<uint64_t> keys(num_clusters);
+    for (k = 0; k < num_clusters; k++)
+    {
+        Cluster *cluster = &(unordered[k]);
+        float latitude = 0.15f + 0.9f * asin(0.85f * (2.0f * uniform(random) - 1.0f));  // shifted north like the land
+        float longitude = 2.0f * M_PI * uniform(random);
+        cluster->center[0] = cos(latitude) * sin(longitude);
+        cluster->center[1] = sin(latitude);
+        cluster->center[2] = cos(latitude) * cos(longitude);
+
+        // Random track direction in the tangent plane
+        float sin_latitude = sin(latitude);
+        float east[3] = {(float)cos(longitude), 0.0f, (float)-sin(longitude)};
+        float north[3] = {sin_latitude * east[2], (float)cos(latitude), -sin_latitude * east[0]};
+        float heading = 2.0f * M_PI * uniform(random);
+        for (axis = 0; axis < 3; axis++)
+        {
+            cluster->tangent[axis] = cos(heading) * east[axis] + sin(heading) * north[axis];
+            cluster->bitangent[axis] = -sin(heading) * east[axis] + cos(heading) * north[axis];
+        }
+        cluster->spread = 0.003f + 0.02f * pow(uniform(random), 2.0f);
+
+        // Morton order of latitude and longitude (with the cluster index in the low bits)
+        uint64_t x = (uint64_t)(65535.0f * longitude / (2.0f * M_PI));
+        uint64_t y = (uint64_t)(65535.0f * (0.5f + latitude / M_PI));
+        uint64_t code = 0;
+        int bit;
+        for (bit = 0; bit < 16; bit++)
+        {
+            code |= (((x >> bit) & 1) << (2 * bit)) | (((y >> bit) & 1) << (2 * bit + 1));
+        }
+        keys[k] = (code << 32) | k;
+    }
+
+    // Runs of points follow the Morton order, so neighboring clusters share chunks
+    std::sort(keys.begin(), keys.end());
+    clusters.resize(num_clusters + 1);
+    uint64_t cluster_points = num_points - (uint64_t)(BACKGROUND_FRACTION * num_points);
+    double cumulative_weight = 0.0;
+    for (k = 0; k < num_clusters; k++)
+    {
+        uint32_t idx = keys[k] & 0xFFFFFFFF;
+        clusters[k] = unordered[idx];
+        clusters[k].first = (uint64_t)(cluster_points * (cumulative_weight / total_weight));
+        cumulative_weight += weights[idx];
+    }
+
+    // Last entry is the background (uniform over the whole globe)
+    memset(&(clusters[num_clusters]), 0, sizeof(Cluster));
+    clusters[num_clusters].first = cluster_points;
+}
+
+void generateChunk(const std::vector<Cluster> &clusters, uint64_t seed, uint64_t chunk_idx, uint64_t first,
+                   uint64_t count, float *data, PcdChunk *chunk)
+{
+    // Fill centers, colors, and sizes of one chunk and compute its bounds
+    uint64_t j;
+    int axis;
+    std::mt19937_64 random(seed * 0x9E3779B97F4A7C15ULL + chunk_idx);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    float *centers = data;
+    float *colors = data + 3 * count;
+    float *sizes = data + 6 * count;
+    uint32_t background = clusters.size() - 1;
+
+    // Cluster owning the chunk's first point
+    uint32_t k = std::upper_bound(clusters.begin(), clusters.end(), first, [](uint64_t point, const Cluster &cluster) {
+        return point < cluster.first;
+    }) - clusters.begin() - 1;
+    for (j = 0; j < count; j++)
+    {
+        while (k < background && first + j >= clusters[k + 1].first)
+        {
+            k++;
+        }
+
+        float direction[3];
+        float heat;
+        if (k == background)
+        {
+            // Sparse stray fixes anywhere on the globe
+            float z = 2.0f * uniform(random) - 1.0f;
+            float angle = 2.0f * M_PI * uniform(random);
+            float r = sqrt(1.0f - z * z);
+            direction[0] = r * cos(angle);
+            direction[1] = z;
+            direction[2] = r * sin(angle);
+            heat = 0.0f;
+        }
+        else
+        {
+            // Gaussian blob around the city, or stretched along its track
+            const Cluster *cluster = &(clusters[k]);
+            float u = normal(random) * cluster->spread;
+            float v = normal(random) * cluster->spread;
+            if (uniform(random) < TRACK_FRACTION)
+            {
+                u *= 4.0f;
+                v *= 0.15f;
+            }
+            for (axis = 0; axis < 3; axis++)
+            {
+                direction[axis] = cluster->center[axis] + u * cluster->tangent[axis] + v * cluster->bitangent[axis];
+            }
+            heat = exp(-0.5f * (u * u + v * v) / (cluster->spread * cluster->spread));
+        }
+        setPoint(centers + 3 * j, direction, 0.0005f * normal(random));
+
+        // Dense cores glow warm yellow, outskirts fade to blue
+        float jitter = 0.05f * (uniform(random) - 0.5f);
+        colors[3 * j] = std::min(std::max(0.15f + 0.85f * heat + jitter, 0.0f), 1.0f);
+        colors[3 * j + 1] = std::min(std::max(0.35f + 0.5f * heat + jitter, 0.0f), 1.0f);
+        colors[3 * j + 2] = std::min(std::max(0.85f - 0.5f * heat + jitter, 0.0f), 1.0f);
+
+        // Log-normal sizes (a couple of pixels across at the default view)
+        sizes[j] = std::min(std::max(0.0025f * (float)exp(0.35f * normal(random)), 0.0008f), 0.01f);
+
+        for (axis = 0; axis < 3; axis++)
+        {
+            float value = centers[3 * j + axis];
+            chunk->bbox_min[axis] = (j == 0) ? value : std::min(chunk->bbox_min[axis], value);
+            chunk->bbox_max[axis] = (j == 0) ? value : std::max(chunk->bbox_max[axis], value);
+        }
+    }
+    chunk->num_points = count;
+}
+
+void setPoint(float *center, const float direction[3], float altitude)
+{
+    // Project onto the globe's surface (with a small altitude offset)
+    float length = sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+    float radius = (length > 0.0f) ? (GLOBE_RADIUS + altitude) / length : 0.0f;
+    center[0] = direction[0] * radius;
+    center[1] = direction[1] * radius;
+    center[2] = direction[2] * radius;
+}
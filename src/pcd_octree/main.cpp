@@ -0,0 +1,368 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "pcdfile.h"
+
+// Build the octree point cloud format (see pcdfile.h) from a text header or chunked .pcd point cloud
+// The whole cloud is held in memory (offline step), the renderer then streams single nodes from the output
+
+typedef struct PointData {
+    std::vector<float> centers;
+    std::vector<float> colors;
+    std::vector<float> sizes;
+    std::vector<uint64_t> codes;  // Morton code of each point (21 bits per axis)
+} PointData;
+
+uint64_t readHeader(std::ifstream &in_file, PcdHeader *header);
+void readSection(std::ifstream &in_file, uint64_t offset, float *buffer, uint64_t count);
+void readPoints(std::ifstream &in_file, PcdHeader *header, PointData &points);
+void computeMortonCodes(PointData &points);
+int buildNode(std::vector<uint64_t> &indices, const PointData &points, int depth, std::vector<PcdOctreeNode> &nodes,
+              std::vector<uint64_t> &order, uint64_t *dropped);
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <input.pcd> <output.pco>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream in_file(argv[1], std::ios::binary);
+    if (!in_file.is_open())
+    {
+        fprintf(stderr, "Error: could not open input file %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    std::ofstream out_file(argv[2], std::ios::binary);
+    if (!out_file.is_open())
+    {
+        fprintf(stderr, "Error: could not open output file %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    PcdHeader input_header;
+    PointData points;
+    readPoints(in_file, &input_header, points);
+    in_file.close();
+
+    // Sort by Morton code, so a regular stride through a node's points is an even spatial sample
+    // and each child's points stay in order
+    uint64_t i;
+    computeMortonCodes(points);
+    std::vector<uint64_t> indices(input_header.num_points);
+    for (i = 0; i < input_header.num_points; i++)
+    {
+        indices[i] = i;
+    }
+    std::sort(indices.begin(), indices.end(), [&points](uint64_t a, uint64_t b) {
+        return points.codes[a] < points.codes[b];
+    });
+
+    // Depth first node table (node data is written in the same order)
+    std::vector<PcdOctreeNode> nodes;
+    std::vector<uint64_t> order;
+    order.reserve(input_header.num_points);
+    uint64_t dropped = 0;
+    if (input_header.num_points > 0)
+    {
+        buildNode(indices, points, 0, nodes, order, &dropped);
+    }
+
+    PcdOctreeHeader header;
+    memset(&header, 0, sizeof(PcdOctreeHeader));
+    memcpy(header.magic, PCD_OCTREE_MAGIC, 4);
+    header.version = PCD_OCTREE_VERSION;
+    header.num_points = order.size();
+    header.num_nodes = nodes.size();
+    header.dropped_points = dropped;
+    memcpy(header.camera_position, input_header.camera_position, 3 * sizeof(float));
+    memcpy(header.camera_target, input_header.camera_target, 3 * sizeof(float));
+    header.num_lights = input_header.num_lights;
+    header.node_points = PCD_OCTREE_NODE_POINTS;
+    memcpy(header.lights, input_header.lights, PCD_MAX_LIGHTS * sizeof(PcdLight));
+
+    // Copy one node at a time (centers, colors, sizes of the node are stored together)
+    uint64_t n, j;
+    uint64_t offset = sizeof(PcdOctreeHeader) + header.num_nodes * sizeof(PcdOctreeNode);
+    std::vector<float> centers(3 * PCD_OCTREE_NODE_POINTS);
+    std::vector<float> colors(3 * PCD_OCTREE_NODE_POINTS);
+    std::vector<float> sizes(PCD_OCTREE_NODE_POINTS);
+    out_file.seekp(offset);
+    for (n = 0; n < header.num_nodes; n++)
+    {
+        uint32_t count = nodes[n].num_points;
+        for (j = 0; j < count; j++)
+        {
+            uint64_t p = order[nodes[n].first_point + j];
+            memcpy(centers.data() + 3 * j, points.centers.data() + 3 * p, 3 * sizeof(float));
+            memcpy(colors.data() + 3 * j, points.colors.data() + 3 * p, 3 * sizeof(float));
+            sizes[j] = points.sizes[p];
+        }
+        nodes[n].offset = offset;
+        out_file.write((char*)centers.data(), 3 * count * sizeof(float));
+        out_file.write((char*)colors.data(), 3 * count * sizeof(float));
+        out_file.write((char*)sizes.data(), count * sizeof(float));
+        offset += 7 * count * sizeof(float);
+    }
+
+    out_file.seekp(0);
+    out_file.write((char*)&header, sizeof(PcdOctreeHeader));
+    out_file.write((char*)nodes.data(), header.num_nodes * sizeof(PcdOctreeNode));
+    if (!out_file.good())
+    {
+        fprintf(stderr, "Error: could not write output file %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+    out_file.close();
+
+    printf("Built %llu octree nodes from %llu points (%llu coincident points dropped)\n",
+           (unsigned long long)header.num_nodes, (unsigned long long)header.num_points, (unsigned long long)dropped);
+
+    return 0;
+}
+
+uint64_t readHeader(std::ifstream &in_file, PcdHeader *header)
+{
+    // Text header: camera, lights, and point count (binary point data follows)
+    const int CAMERA_POSITION = 0;
+    const int CAMERA_TARGET = 1;
+    const int LIGHT_COUNT = 2;
+    const int LIGHTS = 3;
+    const int POINT_COUNT = 4;
+    const int POINTS = 5;
+
+    memset(header, 0, sizeof(PcdHeader));
+
+    std::string line;
+    int section = CAMERA_POSITION;
+    uint32_t light_idx = 0;
+    while (section != POINTS)
+    {
+        if (!std::getline(in_file, line))
+        {
+            fprintf(stderr, "Error: incomplete point cloud header\n");
+            exit(EXIT_FAILURE);
+        }
+        std::istringstream iss(line);
+        PcdLight *light;
+        switch (section)
+        {
+            case CAMERA_POSITION:
+                iss >> header->camera_position[0] >> header->camera_position[1] >> header->camera_position[2];
+                section = CAMERA_TARGET;
+                break;
+            case CAMERA_TARGET:
+                iss >> header->camera_target[0] >> header->camera_target[1] >> header->camera_target[2];
+                section = LIGHT_COUNT;
+                break;
+            case LIGHT_COUNT:
+                iss >> header->num_lights;
+                if (header->num_lights > PCD_MAX_LIGHTS)
+                {
+                    fprintf(stderr, "Error: at most %d lights are supported\n", PCD_MAX_LIGHTS);
+                    exit(EXIT_FAILURE);
+                }
+                section = (header->num_lights > 0) ? LIGHTS : POINT_COUNT;
+                break;
+            case LIGHTS:
+                light = &(header->lights[light_idx]);
+                iss >> light->position[0] >> light->position[1] >> light->position[2] >>
+                       light->color[0] >> light->color[1] >> light->color[2];
+                light_idx++;
+                if (light_idx >= header->num_lights)
+                {
+                    section = POINT_COUNT;
+                }
+                break;
+            case POINT_COUNT:
+                iss >> header->num_points;
+                section = POINTS;
+                break;
+        }
+    }
+    return in_file.tellg();
+}
+
+void readSection(std::ifstream &in_file, uint64_t offset, float *buffer, uint64_t count)
+{
+    in_file.seekg(offset);
+    in_file.read((char*)buffer, count * sizeof(float));
+    if (!in_file.good())
+    {
+        fprintf(stderr, "Error: input file is shorter than its header describes\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void readPoints(std::ifstream &in_file, PcdHeader *header, PointData &points)
+{
+    // Chunked files start with the format's magic number, otherwise a text header
+    char magic[4] = {0, 0, 0, 0};
+    in_file.read(magic, 4);
+    in_file.seekg(0);
+    uint64_t num_points;
+    if (memcmp(magic, PCD_MAGIC, 4) == 0)
+    {
+        in_file.read((char*)header, sizeof(PcdHeader));
+        if (!in_file.good() || header->version != PCD_VERSION || header->num_lights > PCD_MAX_LIGHTS)
+        {
+            fprintf(stderr, "Error: unsupported chunked point cloud header\n");
+            exit(EXIT_FAILURE);
+        }
+        std::vector<PcdChunk> chunks(header->num_chunks);
+        in_file.read((char*)chunks.data(), header->num_chunks * sizeof(PcdChunk));
+        if (!in_file.good())
+        {
+            fprintf(stderr, "Error: input file is shorter than its header describes\n");
+            exit(EXIT_FAILURE);
+        }
+
+        num_points = header->num_points;
+        points.centers.resize(3 * num_points);
+        points.colors.resize(3 * num_points);
+        points.sizes.resize(num_points);
+        uint64_t c;
+        uint64_t first = 0;
+        for (c = 0; c < header->num_chunks; c++)
+        {
+            uint64_t count = chunks[c].num_points;
+            if (first + count > num_points)
+            {
+                fprintf(stderr, "Error: chunk table holds more points than the header describes\n");
+                exit(EXIT_FAILURE);
+            }
+            readSection(in_file, chunks[c].offset, points.centers.data() + 3 * first, 3 * count);
+            readSection(in_file, chunks[c].offset + 3 * count * sizeof(float), points.colors.data() + 3 * first, 3 * count);
+            readSection(in_file, chunks[c].offset + 6 * count * sizeof(float), points.sizes.data() + first, count);
+            first += count;
+        }
+    }
+    else
+    {
+        uint64_t data_offset = readHeader(in_file, header);
+        num_points = header->num_points;
+        points.centers.resize(3 * num_points);
+        points.colors.resize(3 * num_points);
+        points.sizes.resize(num_points);
+        readSection(in_file, data_offset, points.centers.data(), 3 * num_points);
+        readSection(in_file, data_offset + 3 * num_points * sizeof(float), points.colors.data(), 3 * num_points);
+        readSection(in_file, data_offset + 6 * num_points * sizeof(float), points.sizes.data(), num_points);
+    }
+}
+
+void computeMortonCodes(PointData &points)
+{
+    // Interleave 21 bits per axis of each point's position in the bounding box (x highest)
+    uint64_t i, num_points = points.sizes.size();
+    int b, axis;
+    float bbox[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    if (num_points > 0)
+    {
+        for (axis = 0; axis < 3; axis++)
+        {
+            bbox[2 * axis] = points.centers[axis];
+            bbox[2 * axis + 1] = points.centers[axis];
+        }
+    }
+    for (i = 1; i < num_points; i++)
+    {
+        for (axis = 0; axis < 3; axis++)
+        {
+            bbox[2 * axis] = std::min(bbox[2 * axis], points.centers[3 * i + axis]);
+            bbox[2 * axis + 1] = std::max(bbox[2 * axis + 1], points.centers[3 * i + axis]);
+        }
+    }
+
+    points.codes.resize(num_points);
+    for (i = 0; i < num_points; i++)
+    {
+        uint64_t cell[3];
+        for (axis = 0; axis < 3; axis++)
+        {
+            float extent = bbox[2 * axis + 1] - bbox[2 * axis];
+            double t = (extent > 0.0f) ? (points.centers[3 * i + axis] - bbox[2 * axis]) / extent : 0.0;
+            cell[axis] = std::min(std::max((int64_t)(t * 2097152.0), (int64_t)0), (int64_t)2097151);
+        }
+        uint64_t code = 0;
+        for (b = 0; b < 21; b++)
+        {
+            for (axis = 0; axis < 3; axis++)
+            {
+                code |= ((cell[axis] >> b) & 1) << (3 * b + (2 - axis));
+            }
+        }
+        points.codes[i] = code;
+    }
+}
+
+int buildNode(std::vector<uint64_t> &indices, const PointData &points, int depth, std::vector<PcdOctreeNode> &nodes,
+              std::vector<uint64_t> &order, uint64_t *dropped)
+{
+    // Each node keeps a regular stride subsample of its (Morton sorted) subtree, its children hold the rest
+    uint64_t i;
+    int c, axis;
+    PcdOctreeNode node;
+    memset(&node, 0, sizeof(PcdOctreeNode));
+    for (axis = 0; axis < 3; axis++)
+    {
+        node.bbox_min[axis] = points.centers[3 * indices[0] + axis];
+        node.bbox_max[axis] = points.centers[3 * indices[0] + axis];
+    }
+    for (i = 1; i < indices.size(); i++)
+    {
+        for (axis = 0; axis < 3; axis++)
+        {
+            node.bbox_min[axis] = std::min(node.bbox_min[axis], points.centers[3 * indices[i] + axis]);
+            node.bbox_max[axis] = std::max(node.bbox_max[axis], points.centers[3 * indices[i] + axis]);
+        }
+    }
+    for (c = 0; c < 8; c++)
+    {
+        node.children[c] = -1;
+    }
+    node.first_point = order.size();
+
+    // Children split the node's cell at its center (the next Morton code bit of each axis),
+    // a full leaf at max depth drops the rest
+    std::vector<uint64_t> children[8];
+    int shift = 3 * (20 - depth);
+    double stride = (double)indices.size() / (double)PCD_OCTREE_NODE_POINTS;
+    double next_sample = 0.0;
+    for (i = 0; i < indices.size(); i++)
+    {
+        if (i >= next_sample && node.num_points < PCD_OCTREE_NODE_POINTS)
+        {
+            order.push_back(indices[i]);
+            node.max_size = std::max(node.max_size, points.sizes[indices[i]]);
+            node.num_points++;
+            next_sample += std::max(stride, 1.0);
+        }
+        else if (depth == PCD_OCTREE_MAX_DEPTH)
+        {
+            (*dropped)++;
+        }
+        else
+        {
+            c = (points.codes[indices[i]] >> shift) & 7;
+            children[c].push_back(indices[i]);
+        }
+    }
+    std::vector<uint64_t>().swap(indices);
+
+    int node_idx = nodes.size();
+    nodes.push_back(node);
+    for (c = 0; c < 8; c++)
+    {
+        if (!children[c].empty())
+        {
+            nodes[node_idx].children[c] = buildNode(children[c], points, depth + 1, nodes, order, dropped);
+        }
+    }
+    nodes[node_idx].subtree_nodes = nodes.size() - node_idx;
+    return node_idx;
+}
@@ -2,7 +2,15 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <cstring>
+#include <cstddef>
+#include <climits>
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <queue>
+#include <thread>
+#include <random>
 #include <cmath>
 #include <glad/glad.h>
 #define GLFW_INCLUDE_NONE
@@ -10,11 +18,19 @@
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define POINT_BOUNDS_AVX2           // compiled for AVX2, used if the CPU supports it
+#endif
 #include <IceT.h>
 #include <IceTGL3.h>
 #include <IceTMPI.h>
 #include "glslloader.h"
 #include "imgreader.h"
+#include "pcdfile.h"
 
 
 #ifndef M_PI
@@ -23,22 +39,94 @@
 
 #define WINDOW_TITLE "Point Cloud Renderer"
 
+#define POINT_CHUNK_SIZE 65536    // points per spatially sorted chunk
+#define MPI_IO_BLOCK_SIZE (1 << 26) // max floats per collective read call
+#define PARTITION_BUCKET_BITS 15  // leading Morton code bits used to split points across ranks
+#define LUMINANCE_BINS 16
+#define SIZE_BINS 32              // log2 bins starting at 2^-24
+#define OCTREE_NODE_POINTS PCD_OCTREE_NODE_POINTS // points per octree node (and per GPU pool slot)
+#define OCTREE_LOADS_PER_FRAME 32 // nodes uploaded to the GPU pool per frame
+#define OCTREE_MIN_NODE_PIXELS 8.0f // nodes with a smaller projected radius are not refined
+
+// ARB_base_instance (GL 4.2 core, not part of the GL 3.3 loader)
+typedef void (APIENTRY *DrawElementsInstancedBaseInstanceProc)(GLenum mode, GLsizei count, GLenum type,
+                                                               const void *indices, GLsizei instancecount,
+                                                               GLuint baseinstance);
 
 typedef struct GlslProgram {
     GLuint program;
     std::map<std::string,GLint> uniforms;
 } GlslProgram;
 
+typedef struct PointChunk {
+    uint32_t first;               // index of the chunk's first point
+    uint32_t count;
+    uint32_t draw_count;          // leading points drawn this frame (chunks are randomly permuted when decimating)
+    glm::vec3 bbox_min;
+    glm::vec3 bbox_max;
+    float max_size;               // largest point size (pads the bounds for culling)
+    glm::vec3 cone_axis;          // average surface normal (globe: direction from pointcloud_center)
+    float cone_cutoff;            // sine of the normal cone's half angle (> 1 never back-facing)
+} PointChunk;
+
+typedef struct OctreeNode {
+    uint64_t offset;              // byte offset of the node's points in the octree file
+    uint32_t count;               // subsample of the subtree (all points for leaves)
+    glm::vec3 bbox_min;           // bounds of the whole subtree
+    glm::vec3 bbox_max;
+    int children[8];              // -1 if empty
+    bool owned;                   // drawn by this rank
+    bool owned_subtree;           // this node or a descendant is owned
+    int slot;                     // GPU pool slot, -1 if not resident
+    int last_used;                // frame the node was last drawn (LRU eviction)
+} OctreeNode;
+
+typedef struct PointSection {
+    uint64_t offset;              // byte offset in the data file
+    GLuint buffer;                // destination vertex buffer
+    uint64_t first;               // first destination float
+    uint64_t count;               // number of floats
+} PointSection;
+
+typedef struct QuantizedPoint {
+    GLushort position[3];         // normalized within the chunk's bounds
+    GLhalf size;
+    GLubyte color[4];             // rgb + padding (keeps 4-byte alignment)
+} QuantizedPoint;
+
+typedef struct QuantizationError {
+    double max_position;          // world units
+    double sum_sq_position;
+    double max_color;
+    double max_size;              // relative to the point's size
+} QuantizationError;
+
 typedef struct Scene {
     glm::vec3 camera_position;
     glm::vec3 camera_target;
     int num_lights;
     GLfloat *light_positions;
     GLfloat *light_colors;
-    int num_points;
+    int num_points;               // this rank's points (loading aborts past INT_MAX)
+    bool chunked_file;            // chunked binary format (pcdfile.h) instead of text header + arrays
     GLuint pointcloud_vertex_array;
+    GLuint pointcloud_sprite_vertex_array;
     int pointcloud_face_index_count;
+    GLuint point_center_buffer;
+    GLuint point_color_buffer;
+    GLuint point_size_buffer;
+    QuantizationError quantization_error;
     glm::dvec3 pointcloud_center;
+    std::vector<PointChunk> chunks;
+    std::vector<int> chunk_order;  // draw order (front to back when sorted)
+    std::vector<OctreeNode> octree;  // whole node table (depth first), points stay in the file
+    std::ifstream octree_file;
+    std::vector<GLfloat> octree_staging;  // one node's centers, colors, and sizes
+    std::vector<int> pool_slots;  // node resident in each GPU slot, -1 if free
+    uint64_t octree_dropped_points;  // all ranks: coincident points beyond a full leaf at max depth
+    std::vector<uint64_t> luminance_histogram;
+    std::vector<uint64_t> size_histogram;
+    float max_point_size;
 } Scene;
 
 typedef struct AppData {
@@ -54,7 +142,25 @@ typedef struct AppData {
     IceTContext context;
     IceTImage image;
     // Rendering info
+    bool point_sprites;           // GL_POINTS (one vertex per point) instead of instanced quads
     std::map<std::string, GlslProgram> glsl_program;
+    GlslProgram *pointcloud_program;
+    bool conservative_depth;      // early-Z friendly sphere depth, drawn front to back
+    bool conservative_depth_ext;  // GL_ARB_conservative_depth (else flat quads at the sphere front)
+    DrawElementsInstancedBaseInstanceProc draw_base_instance;  // NULL if unsupported
+    bool quantize;                // 12 byte interleaved points instead of 28 bytes of floats
+    bool mpi_io;                  // collective MPI-IO reads instead of per-rank ifstream seeks
+    bool spatial_partition;       // redistribute points so each rank owns a compact region
+    int point_budget;             // octree LOD: max points drawn per rank per frame (0 = draw all)
+    int staging_mb;               // read straight into mapped vertex buffers through this much host memory (0 = off)
+    int num_threads;              // threads for passes over the point data
+    bool avx2;
+    bool chunk_culling;           // skip chunks outside the frustum
+    bool backface_chunks;         // also skip chunks whose normal cone faces away (lossy, see cullPointChunks)
+    float points_per_pixel;       // decimate chunks to this density of their projected area (0 = off)
+    int progressive_slices;       // refine a still view over this many frames (0 = off)
+    int progressive_slice;        // next slice to accumulate
+    glm::dmat4 accumulation_modelview;  // view the accumulation buffer holds
     GLuint vertex_position_attrib;
     GLuint vertex_texcoord_attrib;
     GLuint point_center_attrib;
@@ -66,10 +172,28 @@ typedef struct AppData {
     GLuint framebuffer;           // only used in IceT generic compositing
     GLuint framebuffer_texture;   // only used in IceT generic compositing
     GLuint framebuffer_depth;     // only used in IceT generic compositing
+    GLuint accumulation_framebuffer;  // only used in progressive mode
+    GLuint accumulation_texture;
+    GLuint accumulation_depth;
+    GLuint resolve_vertex_array;  // empty (full-screen triangle from gl_VertexID)
     // Frame counter
     int frame_count;
     double pixel_read_time;
     double pixel_compress_time;
+    double render_time;
+    double data_read_time;        // slowest rank's point data read
+    double partition_time;
+    double statistics_time;       // bounds, chunk bounds, and histograms
+    double composite_time;
+    double active_pixels;         // pixels covered by each rank's projected bounds (IceT OGL3 only)
+    double lod_drawn_points;
+    double culled_drawn_points;
+    double culled_drawn_chunks;
+    double culled_frustum_chunks;
+    double culled_backfacing_chunks;
+    double decimated_drawn_points;
+    int accumulation_resets;      // views refined in progressive mode
+    double lod_loaded_nodes;
     // Scene info
     glm::vec4 background_color;
     glm::dmat4 projection_matrix;
@@ -80,7 +204,8 @@ typedef struct AppData {
     glm::mat4 background_modelview_matrix;
     double rotate_y;
     Scene scene;
-    // Output file name
+    // Input data and output file names
+    std::string data_file;
     std::string outfile;
 } AppData;
 
@@ -94,12 +219,62 @@ void renderIceTGeneric(const IceTDouble *projection_matrix, const IceTDouble *mo
                        const IceTFloat *background_color, const IceTInt *readback_viewport,
                        IceTImage result);
 void render();
+void renderProgressive(GLuint framebuffer);
 void display();
 void mat4ToFloatArray(glm::dmat4 mat4, float array[16]);
-void loadPointCloudShader();
+void loadPointCloudShader(const char *defines);
 void loadCompositeShader();
+void loadResolveShader();
 void loadPointCloudData(const char *filename, float bbox[6]);
+bool isChunkedPointCloud(const char *filename);
+bool isOctreePointCloud(const char *filename);
+void readPointCloud(const char *filename, GLfloat **point_centers, GLfloat **point_colors, GLfloat **point_sizes);
+void readChunkedPointCloud(const char *filename, GLfloat **point_centers, GLfloat **point_colors, GLfloat **point_sizes);
+void readChunkTable(const char *filename, std::ifstream &scene_file, std::vector<PcdChunk> &chunks,
+                    uint64_t *chunk_start, uint64_t *chunk_end);
+void loadPointCloudDataStaged(const char *filename, float bbox[6]);
+void stagePointSection(std::ifstream &scene_file, const PointSection *section, std::vector<GLfloat> &staging);
+void loadPointCloudOctree(const char *filename, float bbox[6]);
+void readOctreeNode(const OctreeNode *node);
+void readChunkSection(std::ifstream &scene_file, MPI_File file, uint64_t offset, GLfloat *buffer, uint64_t count);
+void setRankPointCount(uint64_t num_points);
+uint64_t readPointCloudHeader(std::ifstream &scene_file);
+void broadcastPointCloudHeader(uint64_t *total_points, uint64_t *data_offset);
+void readPointsMpiIo(const char *filename, uint64_t data_offset, uint64_t total_points, uint64_t point_idx_start,
+                     GLfloat *point_centers, GLfloat *point_colors, GLfloat *point_sizes);
+void readAtAll(MPI_File file, MPI_Offset offset, GLfloat *buffer, uint64_t count, uint64_t max_count);
+void partitionPointsSpatially(GLfloat **point_centers, GLfloat **point_colors, GLfloat **point_sizes);
+void computeBoundingBox(const GLfloat *point_centers, uint32_t num_points, float bbox[6]);
+void computePointCloudCenter(const float bbox[6]);
+void chunksBoundingBox(float bbox[6]);
+void pointBounds(const GLfloat *point_centers, uint32_t num_points, float bounds_min[3], float bounds_max[3]);
+#ifdef POINT_BOUNDS_AVX2
+uint32_t pointBoundsAvx2(const GLfloat *point_centers, uint32_t num_points, float bounds_min[3], float bounds_max[3]);
+#endif
+void updateOctreeLod();
+bool loadOctreeNode(int node_idx);
 GLuint createPointCloudVertexArray(GLfloat *point_centers, GLfloat *point_colors, GLfloat *point_sizes);
+GLuint createPointSpriteVertexArray();
+void sortPointsSpatially(GLfloat *point_centers, GLfloat *point_colors, GLfloat *point_sizes, const float bbox[6]);
+uint32_t mortonCode(const GLfloat *point, const float bbox[6]);
+void createPointChunks(const GLfloat *point_centers, const GLfloat *point_colors, const GLfloat *point_sizes);
+void chunkStatistics(const GLfloat *point_centers, const GLfloat *point_colors, const GLfloat *point_sizes,
+                     int thread, uint64_t *luminance_histogram, uint64_t *size_histogram);
+void computeChunkCones();
+int luminanceBin(const GLfloat *color);
+int sizeBin(GLfloat size);
+void sortChunksFrontToBack();
+void cullPointChunks();
+void frustumPlanes(const glm::dmat4& mvp, glm::vec4 planes[6]);
+bool boxOutsideFrustum(const glm::vec4 planes[6], const glm::vec3& bbox_min, const glm::vec3& bbox_max);
+void permutePointChunks(GLfloat *point_centers, GLfloat *point_colors, GLfloat *point_sizes);
+void decimatePointChunks();
+void drawPointChunk(const PointChunk *chunk);
+void quantizePoints(const GLfloat *point_centers, const GLfloat *point_colors, const GLfloat *point_sizes,
+                    QuantizedPoint *points);
+void setPointAttribPointers(uint32_t first);
+GLhalf floatToHalf(float value);
+float halfToFloat(GLhalf value);
 GLuint createPlaneVertexArray();
 
 AppData app;
@@ -191,6 +366,75 @@ int main(int argc, char **argv)
     read_time = app.pixel_read_time;
     MPI_Reduce(&read_time, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
     read_time = collect / (double)app.num_proc;
+    double render_time = app.render_time;
+    MPI_Reduce(&render_time, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    render_time = collect / (double)app.num_proc;
+    // Vertex shader invocations (quads reuse their 4 vertices through the post-transform cache)
+    double drawn_points = (double)app.scene.num_points;
+    if (app.points_per_pixel > 0.0f)
+    {
+        drawn_points = app.decimated_drawn_points / animation_frames;
+    }
+    else if (app.chunk_culling)
+    {
+        drawn_points = app.culled_drawn_points / animation_frames;
+    }
+    else if (app.point_budget > 0)
+    {
+        drawn_points = app.lod_drawn_points / animation_frames;
+    }
+    if (app.progressive_slices > 0)
+    {
+        drawn_points /= app.progressive_slices;
+    }
+    double culling[3] = {app.culled_drawn_chunks, app.culled_frustum_chunks, app.culled_backfacing_chunks};
+    double total_culling[3];
+    MPI_Reduce(culling, total_culling, 3, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    double vertices = drawn_points * (app.point_sprites ? 1.0 : 4.0);
+    MPI_Reduce(&vertices, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    vertices = collect;
+    int num_chunks = app.scene.chunks.size();
+    int total_chunks;
+    MPI_Reduce(&num_chunks, &total_chunks, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    QuantizationError error;
+    MPI_Reduce(&(app.scene.quantization_error.max_position), &(error.max_position), 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&(app.scene.quantization_error.sum_sq_position), &(error.sum_sq_position), 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&(app.scene.quantization_error.max_color), &(error.max_color), 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&(app.scene.quantization_error.max_size), &(error.max_size), 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    double composite_time = app.composite_time;
+    MPI_Reduce(&composite_time, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    composite_time = collect / (double)app.num_proc;
+    double active_pixels = app.active_pixels;
+    MPI_Reduce(&active_pixels, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    active_pixels = collect;
+    double loaded_nodes = app.lod_loaded_nodes;
+    MPI_Reduce(&loaded_nodes, &collect, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    loaded_nodes = collect / (double)app.num_proc;
+    // Every rank holds the whole node table
+    int num_nodes = app.scene.octree.size();
+    int total_nodes;
+    MPI_Reduce(&num_nodes, &total_nodes, 1, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD);
+    std::vector<uint64_t> luminance_histogram(LUMINANCE_BINS, 0);
+    std::vector<uint64_t> size_histogram(SIZE_BINS, 0);
+    MPI_Reduce(app.scene.luminance_histogram.data(), luminance_histogram.data(), LUMINANCE_BINS, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(app.scene.size_histogram.data(), size_histogram.data(), SIZE_BINS, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    double statistics_time;
+    MPI_Reduce(&(app.statistics_time), &statistics_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    double peak_rss = 0.0;
+#ifndef _WIN32
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    peak_rss = usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    peak_rss = usage.ru_maxrss / 1024.0;
+#endif
+#endif
+    MPI_Reduce(&peak_rss, &collect, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    peak_rss = collect;
+    double num_points = app.scene.num_points;
+    double total_points;
+    MPI_Reduce(&num_points, &total_points, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
 
     if (app.rank == 0)
     {
@@ -216,6 +460,88 @@ int main(int argc, char **argv)
                 composite_method, app.num_proc);
         fprintf(fp, "Average FPS, Average Compression Compute Time, Average Memory Transfer Time\n");
         fprintf(fp, "%.3lf, %.6lf, %.6lf\n\n", avg_fps, avg_compress_time, avg_read_time);
+        fprintf(fp, "Point Render Mode, Vertices per Frame, Vertices per Second, Average Render Time\n");
+        fprintf(fp, "%s, %.0lf, %.4e, %.6lf\n\n", app.point_sprites ? "Point Sprites" : "Instanced Quads", vertices,
+                vertices * avg_fps, render_time / animation_frames);
+        const char *depth_mode = "Per-Fragment gl_FragDepth";
+        if (app.conservative_depth)
+        {
+            depth_mode = app.conservative_depth_ext ? "Conservative gl_FragDepth" : "Flat Quad at Sphere Front";
+        }
+        fprintf(fp, "Depth Mode, Front-to-Back Chunks, Point Chunks\n");
+        fprintf(fp, "%s, %s, %d\n\n", depth_mode, app.conservative_depth ? "Yes" : "No", total_chunks);
+        int point_bytes = app.quantize ? sizeof(QuantizedPoint) : 7 * sizeof(GLfloat);
+        fprintf(fp, "Point Layout, Bytes per Point, Point Buffer Size (MB), Max Position Error, RMS Position Error, Max Color Error, Max Relative Size Error\n");
+        fprintf(fp, "%s, %d, %.3lf, %.4e, %.4e, %.4e, %.4e\n\n", app.quantize ? "Quantized" : "Float", point_bytes,
+                total_points * point_bytes / (1024.0 * 1024.0), error.max_position,
+                sqrt(error.sum_sq_position / std::max(total_points, 1.0)), error.max_color, error.max_size);
+        double read_mb = total_points * 7.0 * sizeof(GLfloat) / (1024.0 * 1024.0);
+        const char *reader = app.mpi_io ? "MPI-IO Collective" : "ifstream";
+        if (app.scene.chunked_file)
+        {
+            reader = app.mpi_io ? "MPI-IO per Chunk" : "ifstream per Chunk";
+        }
+        const char *format = app.scene.chunked_file ? "Chunked v2" : "Text Header v1";
+        if (app.staging_mb > 0)
+        {
+            reader = "ifstream Staged to GPU";
+        }
+        if (app.point_budget > 0)
+        {
+            reader = "ifstream per Node";
+            format = "Octree v1";
+        }
+        fprintf(fp, "Point Reader, Data Format, Data Read (MB), Read Time, Aggregate Read Bandwidth (MB/s), Staging Size (MB), Max Peak Host RSS (MB)\n");
+        fprintf(fp, "%s, %s, %.3lf, %.6lf, %.3lf, %d, %.3lf\n\n", reader, format,
+                read_mb, app.data_read_time, read_mb / app.data_read_time, app.staging_mb, peak_rss);
+        if (app.chunk_culling)
+        {
+            fprintf(fp, "Chunk Culling, Average Drawn Chunks per Frame, Average Frustum Culled Chunks per Frame, Average Back-Facing Culled Chunks per Frame\n");
+            fprintf(fp, "%s, %.3lf, %.3lf, %.3lf\n\n", app.backface_chunks ? "Frustum + Normal Cone" : "Frustum",
+                    total_culling[0] / animation_frames,
+                    total_culling[1] / animation_frames, total_culling[2] / animation_frames);
+        }
+        if (app.points_per_pixel > 0.0f)
+        {
+            fprintf(fp, "Points per Pixel, Average Effective Points Drawn per Frame, Fraction of Points Drawn\n");
+            fprintf(fp, "%.3f, %.3lf, %.6lf\n\n", app.points_per_pixel, vertices / (app.point_sprites ? 1.0 : 4.0),
+                    vertices / (app.point_sprites ? 1.0 : 4.0) / total_points);
+        }
+        if (app.progressive_slices > 0)
+        {
+            fprintf(fp, "Progressive Slices per View, Views Refined\n");
+            fprintf(fp, "%d, %d\n\n", app.progressive_slices, app.accumulation_resets);
+        }
+        fprintf(fp, "Statistics Threads per Rank, AVX2, Max Statistics Pass Time\n");
+        fprintf(fp, "%d, %s, %.6lf\n\n", app.num_threads, app.avx2 ? "Yes" : "No", statistics_time);
+        int i;
+        fprintf(fp, "Color Luminance Histogram (%d bins over [0, 1])\n", LUMINANCE_BINS);
+        for (i = 0; i < LUMINANCE_BINS; i++)
+        {
+            fprintf(fp, "%s%llu", (i > 0) ? ", " : "", (unsigned long long)luminance_histogram[i]);
+        }
+        fprintf(fp, "\n\nSize Histogram (%d log2 bins from 2^-24)\n", SIZE_BINS);
+        for (i = 0; i < SIZE_BINS; i++)
+        {
+            fprintf(fp, "%s%llu", (i > 0) ? ", " : "", (unsigned long long)size_histogram[i]);
+        }
+        fprintf(fp, "\n\n");
+        char active_pixels_str[32];
+#ifdef USE_ICET_OGL3
+        snprintf(active_pixels_str, 32, "%.0lf", active_pixels / animation_frames);
+#else
+        snprintf(active_pixels_str, 32, "N/A");
+#endif
+        fprintf(fp, "Point Distribution, Partition Time, Average Active Pixels per Frame, Average Composite Time\n");
+        fprintf(fp, "%s, %.6lf, %s, %.6lf\n\n", app.spatial_partition ? "Morton Partition" : "File Order",
+                app.partition_time, active_pixels_str, composite_time / animation_frames);
+        if (app.point_budget > 0)
+        {
+            fprintf(fp, "Point Budget per Rank, Octree Nodes, GPU Pool Points per Rank, Average Drawn Points per Frame, Average Nodes Loaded per Frame, Dropped Points\n");
+            fprintf(fp, "%d, %d, %d, %.0lf, %.3lf, %llu\n\n", app.point_budget, total_nodes,
+                    (int)app.scene.pool_slots.size() * OCTREE_NODE_POINTS, vertices / (app.point_sprites ? 1.0 : 4.0),
+                    loaded_nodes / animation_frames, (unsigned long long)app.scene.octree_dropped_points);
+        }
         fclose(fp);
     }
 
@@ -234,6 +560,19 @@ void parseCommandLineArgs(int argc, char **argv)
     // Defaults
     app.window_width = 1280;
     app.window_height = 720;
+    app.point_sprites = false;
+    app.conservative_depth = false;
+    app.quantize = false;
+    app.mpi_io = false;
+    app.spatial_partition = false;
+    app.point_budget = 0;
+    app.staging_mb = 0;
+    app.num_threads = 0;          // share the node's cores among its ranks (resolved below)
+    app.chunk_culling = false;
+    app.backface_chunks = false;
+    app.points_per_pixel = 0.0f;
+    app.progressive_slices = 0;
+    app.data_file = "/projects/visualization/marrinan/data/OpenStreetMap_BulkGPS/osm_gps_2012_138.5M.pcd";
 
     // User options
     int i = 1;
@@ -250,6 +589,73 @@ void parseCommandLineArgs(int argc, char **argv)
             app.window_height = std::stoi(argv[i + 1]);
             i += 2;
         }
+        else if (argument == "--point-sprites")
+        {
+            app.point_sprites = true;
+            i += 1;
+        }
+        else if (argument == "--conservative-depth")
+        {
+            app.conservative_depth = true;
+            i += 1;
+        }
+        else if (argument == "--quantize")
+        {
+            app.quantize = true;
+            i += 1;
+        }
+        else if (argument == "--mpi-io")
+        {
+            app.mpi_io = true;
+            i += 1;
+        }
+        else if (argument == "--spatial-partition")
+        {
+            app.spatial_partition = true;
+            i += 1;
+        }
+        else if (argument == "--point-budget" && i < argc - 1)
+        {
+            app.point_budget = std::stoi(argv[i + 1]);
+            i += 2;
+        }
+        else if (argument == "--staging-mb" && i < argc - 1)
+        {
+            app.staging_mb = std::stoi(argv[i + 1]);
+            i += 2;
+        }
+        else if (argument == "--chunk-culling")
+        {
+            app.chunk_culling = true;
+            i += 1;
+        }
+        else if (argument == "--backface-chunks")
+        {
+            // Cone test runs in the chunk culling pass
+            app.chunk_culling = true;
+            app.backface_chunks = true;
+            i += 1;
+        }
+        else if (argument == "--points-per-pixel" && i < argc - 1)
+        {
+            app.points_per_pixel = std::stof(argv[i + 1]);
+            i += 2;
+        }
+        else if (argument == "--progressive" && i < argc - 1)
+        {
+            app.progressive_slices = std::stoi(argv[i + 1]);
+            i += 2;
+        }
+        else if (argument == "--threads" && i < argc - 1)
+        {
+            app.num_threads = std::max(std::stoi(argv[i + 1]), 1);
+            i += 2;
+        }
+        else if (argument == "--data" && i < argc - 1)
+        {
+            app.data_file = argv[i + 1];
+            i += 2;
+        }
         else if ((argument == "--outfile" || argument == "-o") && i < argc - 1)
         {
             app.outfile = argv[i + 1];
@@ -260,6 +666,17 @@ void parseCommandLineArgs(int argc, char **argv)
             i += 1;
         }
     }
+
+    // Ranks on the same node split its hardware threads (unless --threads is given)
+    if (app.num_threads == 0)
+    {
+        MPI_Comm node_comm;
+        int ranks_per_node;
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_comm);
+        MPI_Comm_size(node_comm, &ranks_per_node);
+        MPI_Comm_free(&node_comm);
+        app.num_threads = std::max((int)std::thread::hardware_concurrency() / ranks_per_node, 1);
+    }
 }
 
 void init()
@@ -318,6 +735,18 @@ void init()
     app.frame_count = 0;
     app.pixel_read_time = 0.0;
     app.pixel_compress_time = 0.0;
+    app.render_time = 0.0;
+    app.composite_time = 0.0;
+    app.active_pixels = 0.0;
+    app.lod_drawn_points = 0.0;
+    app.culled_drawn_points = 0.0;
+    app.culled_drawn_chunks = 0.0;
+    app.culled_frustum_chunks = 0.0;
+    app.culled_backfacing_chunks = 0.0;
+    app.decimated_drawn_points = 0.0;
+    app.accumulation_resets = 0;
+    app.progressive_slice = 0;
+    app.lod_loaded_nodes = 0.0;
 
     // Initialize OpenGL stuff
     app.background_color = glm::vec4(0.0, 0.0, 0.0, 0.0);
@@ -326,6 +755,27 @@ void init()
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); 
     glViewport(0, 0, app.window_width, app.window_height);
+    if (app.point_sprites)
+    {
+        // Sprite size is computed in the vertex shader
+        glEnable(GL_PROGRAM_POINT_SIZE);
+    }
+
+    // Vectorized bounds when the CPU has AVX2
+#ifdef POINT_BOUNDS_AVX2
+    app.avx2 = __builtin_cpu_supports("avx2");
+#else
+    app.avx2 = false;
+#endif
+    app.statistics_time = 0.0;
+
+    // Optional extensions (loaded directly, the GL 3.3 loader does not include them)
+    app.conservative_depth_ext = app.conservative_depth && glfwExtensionSupported("GL_ARB_conservative_depth");
+    app.draw_base_instance = NULL;
+    if (glfwExtensionSupported("GL_ARB_base_instance"))
+    {
+        app.draw_base_instance = (DrawElementsInstancedBaseInstanceProc)glfwGetProcAddress("glDrawElementsInstancedBaseInstance");
+    }
 
     // Set GLSL attributes
     app.vertex_position_attrib = 0;
@@ -368,26 +818,162 @@ void init()
         freeRgba(bg_pixels);
     }
 
+    // LOD streams nodes from an octree file (written by pcd_octree), which holds nothing else to draw
+    bool octree_file = isOctreePointCloud(app.data_file.c_str());
+    if (app.point_budget > 0 && !octree_file)
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Warning: --point-budget needs an octree point cloud from pcd_octree (disabled)\n");
+        }
+        app.point_budget = 0;
+    }
+    if (app.point_budget == 0 && octree_file)
+    {
+        fprintf(stderr, "Error: octree point clouds are only drawn with --point-budget\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    // Each rank owns a contiguous range of the file's depth first node order
+    if (app.point_budget > 0 && (app.spatial_partition || app.mpi_io))
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Warning: --spatial-partition and --mpi-io are not supported with --point-budget (disabled)\n");
+        }
+        app.spatial_partition = false;
+        app.mpi_io = false;
+    }
+    // Budget must fit at least the octree root
+    if (app.point_budget > 0 && app.point_budget < OCTREE_NODE_POINTS)
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Warning: point budget raised to the octree node size (%d)\n", OCTREE_NODE_POINTS);
+        }
+        app.point_budget = OCTREE_NODE_POINTS;
+    }
+    // Staged loads copy file order points straight to the GPU (no host-side reordering or conversion)
+    if (app.staging_mb > 0 && (app.quantize || app.spatial_partition || app.point_budget > 0))
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Warning: --staging-mb is not supported with --quantize, --spatial-partition, or --point-budget (disabled)\n");
+        }
+        app.staging_mb = 0;
+    }
+    if (app.staging_mb > 0 && app.mpi_io)
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Warning: --mpi-io is not supported with --staging-mb (disabled)\n");
+        }
+        app.mpi_io = false;
+    }
+    // Staged chunks are file order runs whose bounds span nearly the whole globe (nothing to cull or order)
+    if (app.staging_mb > 0 && (app.chunk_culling || app.conservative_depth))
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Warning: --chunk-culling and --conservative-depth are not supported with --staging-mb (disabled)\n");
+        }
+        app.chunk_culling = false;
+        app.backface_chunks = false;
+        app.conservative_depth = false;
+    }
+
+    // Decimation needs each chunk randomly permuted on the host before upload
+    if (app.points_per_pixel > 0.0f && (app.staging_mb > 0 || app.point_budget > 0))
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Warning: --points-per-pixel is not supported with --staging-mb or --point-budget (disabled)\n");
+        }
+        app.points_per_pixel = 0.0f;
+    }
+
+    // Slices are runs of the randomly permuted chunks (and take the place of decimation)
+    if (app.progressive_slices > 0 && (app.staging_mb > 0 || app.point_budget > 0))
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Warning: --progressive is not supported with --staging-mb or --point-budget (disabled)\n");
+        }
+        app.progressive_slices = 0;
+    }
+    if (app.progressive_slices > 0 && app.points_per_pixel > 0.0f)
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Warning: --points-per-pixel is not supported with --progressive (disabled)\n");
+        }
+        app.points_per_pixel = 0.0f;
+    }
+
+    // Octree nodes are uploaded as float points
+    if (app.quantize && app.point_budget > 0)
+    {
+        if (app.rank == 0)
+        {
+            fprintf(stderr, "Warning: --quantize is not supported with --point-budget (disabled)\n");
+        }
+        app.quantize = false;
+    }
+
     // Load GLSL shader program
-    loadPointCloudShader();
+    std::string defines = "";
+    if (app.point_sprites)
+    {
+        defines += "#define POINT_SPRITES\n";
+    }
+    if (app.conservative_depth)
+    {
+        defines += app.conservative_depth_ext ? "#define CONSERVATIVE_DEPTH\n" : "#define FLAT_DEPTH\n";
+    }
+    if (app.quantize)
+    {
+        defines += "#define QUANTIZED\n";
+    }
+    loadPointCloudShader(defines.c_str());
     loadCompositeShader();
 
+    // Progressive mode keeps its own framebuffer that persists across frames of a still view
+    if (app.progressive_slices > 0)
+    {
+        loadResolveShader();
+        glGenVertexArrays(1, &(app.resolve_vertex_array));
+
+        glGenTextures(1, &(app.accumulation_texture));
+        glBindTexture(GL_TEXTURE_2D, app.accumulation_texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, app.window_width, app.window_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+        glGenTextures(1, &(app.accumulation_depth));
+        glBindTexture(GL_TEXTURE_2D, app.accumulation_depth);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, app.window_width, app.window_height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &(app.accumulation_framebuffer));
+        glBindFramebuffer(GL_FRAMEBUFFER, app.accumulation_framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, app.accumulation_texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, app.accumulation_depth, 0);
+        GLenum accumulation_buffers[1] = {GL_COLOR_ATTACHMENT0};
+        glDrawBuffers(1, accumulation_buffers);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
     // Load point cloud data
     float bbox[6];
     //loadPointCloudData("resrc/data/osm_gps_2012.pcd", bbox);
     //loadPointCloudData("/projects/visualization/marrinan/data/OpenStreetMap_BulkGPS/osm_gps_2012_277M.pcd", bbox);
-    loadPointCloudData("/projects/visualization/marrinan/data/OpenStreetMap_BulkGPS/osm_gps_2012_138.5M.pcd", bbox);
+    //loadPointCloudData("/projects/visualization/marrinan/data/OpenStreetMap_BulkGPS/osm_gps_2012_138.5M.pcd", bbox);
+    loadPointCloudData(app.data_file.c_str(), bbox);
 #ifdef USE_ICET_OGL3
     icetBoundingBoxf(bbox[0], bbox[1], bbox[2], bbox[3], bbox[4], bbox[5]);
 #endif
-    float x_min, y_min, z_min, x_max, y_max, z_max;
-    MPI_Allreduce(&(bbox[0]), &x_min, 1, MPI_FLOAT, MPI_MIN, MPI_COMM_WORLD);
-    MPI_Allreduce(&(bbox[2]), &y_min, 1, MPI_FLOAT, MPI_MIN, MPI_COMM_WORLD);
-    MPI_Allreduce(&(bbox[4]), &z_min, 1, MPI_FLOAT, MPI_MIN, MPI_COMM_WORLD);
-    MPI_Allreduce(&(bbox[1]), &x_max, 1, MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD);
-    MPI_Allreduce(&(bbox[3]), &y_max, 1, MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD);
-    MPI_Allreduce(&(bbox[5]), &z_max, 1, MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD);
-    app.scene.pointcloud_center = glm::vec3((x_min + x_max) / 2.0, (y_min + y_max) / 2.0, (z_min + z_max) / 2.0);
 
     // Create projection, view, and model matrices
     float clip_z[2] = {0.1, 100.0};
@@ -413,16 +999,20 @@ void init()
     mat4ToFloatArray(app.model_matrix, mat4_model);
     mat4ToFloatArray(app.view_matrix, mat4_view);
 
-    glUseProgram(app.glsl_program["pointcloud"].program);
-    glUniformMatrix4fv(app.glsl_program["pointcloud"].uniforms["projection_matrix"], 1, GL_FALSE, mat4_proj);
-    glUniformMatrix4fv(app.glsl_program["pointcloud"].uniforms["view_matrix"], 1, GL_FALSE, mat4_view);
-    glUniformMatrix4fv(app.glsl_program["pointcloud"].uniforms["model_matrix"], 1, GL_FALSE, mat4_model);
-    glUniform2fv(app.glsl_program["pointcloud"].uniforms["clip_z"], 1, clip_z);
-    glUniform3fv(app.glsl_program["pointcloud"].uniforms["camera_position"], 1, glm::value_ptr(app.scene.camera_position));
-    glUniform3fv(app.glsl_program["pointcloud"].uniforms["light_ambient"], 1, ambient);
-    glUniform1i(app.glsl_program["pointcloud"].uniforms["num_lights"], app.scene.num_lights);
-    glUniform3fv(app.glsl_program["pointcloud"].uniforms["light_position[0]"], app.scene.num_lights, app.scene.light_positions);
-    glUniform3fv(app.glsl_program["pointcloud"].uniforms["light_color[0]"], app.scene.num_lights, app.scene.light_colors);
+    glUseProgram(app.pointcloud_program->program);
+    glUniformMatrix4fv(app.pointcloud_program->uniforms["projection_matrix"], 1, GL_FALSE, mat4_proj);
+    glUniformMatrix4fv(app.pointcloud_program->uniforms["view_matrix"], 1, GL_FALSE, mat4_view);
+    glUniformMatrix4fv(app.pointcloud_program->uniforms["model_matrix"], 1, GL_FALSE, mat4_model);
+    glUniform2fv(app.pointcloud_program->uniforms["clip_z"], 1, clip_z);
+    glUniform3fv(app.pointcloud_program->uniforms["camera_position"], 1, glm::value_ptr(app.scene.camera_position));
+    glUniform3fv(app.pointcloud_program->uniforms["light_ambient"], 1, ambient);
+    glUniform1i(app.pointcloud_program->uniforms["num_lights"], app.scene.num_lights);
+    glUniform3fv(app.pointcloud_program->uniforms["light_position[0]"], app.scene.num_lights, app.scene.light_positions);
+    glUniform3fv(app.pointcloud_program->uniforms["light_color[0]"], app.scene.num_lights, app.scene.light_colors);
+    if (app.point_sprites)
+    {
+        glUniform1f(app.pointcloud_program->uniforms["viewport_height"], (float)app.window_height);
+    }
     
     glUseProgram(app.glsl_program["nolight"].program);
     glUniformMatrix4fv(app.glsl_program["nolight"].uniforms["projection_matrix"], 1, GL_FALSE, glm::value_ptr(app.composite_projection_matrix));
@@ -431,6 +1021,28 @@ void init()
 
 void doFrame()
 {
+    // Select (and stream in) the octree nodes to draw this frame
+    if (app.point_budget > 0)
+    {
+        updateOctreeLod();
+    }
+    if (app.chunk_culling)
+    {
+        cullPointChunks();
+    }
+    if (app.points_per_pixel > 0.0f)
+    {
+        decimatePointChunks();
+    }
+
+    // A camera change restarts accumulation of the progressive image
+    if (app.progressive_slices > 0 && (app.progressive_slice == 0 || app.view_matrix * app.model_matrix != app.accumulation_modelview))
+    {
+        app.accumulation_modelview = app.view_matrix * app.model_matrix;
+        app.progressive_slice = 0;
+        app.accumulation_resets++;
+    }
+
     // Offscreen render and composit
     glm::dmat4 modelview_matrix = app.view_matrix * app.model_matrix;
 #ifdef USE_ICET_OGL3
@@ -449,11 +1061,32 @@ void doFrame()
     icetGetDoublev(ICET_COMPRESS_TIME, &compress_time);
     app.pixel_compress_time += compress_time;
 #endif
+    double render_time;
+    icetGetDoublev(ICET_RENDER_TIME, &render_time);
+    app.render_time += render_time;
+    double composite_time;
+    icetGetDoublev(ICET_COMPOSITE_TIME, &composite_time);
+    app.composite_time += composite_time;
+#ifdef USE_ICET_OGL3
+    // Generic compositing reads back whole frames (no bounding box is set), so it reports N/A
+    IceTInt contained_viewport[4];
+    icetGetIntegerv(ICET_CONTAINED_VIEWPORT, contained_viewport);
+    app.active_pixels += (double)contained_viewport[2] * (double)contained_viewport[3];
+#endif
 
     // Render composited image to fullscreen quad on screen of rank 0
     display();
 
-    // Animate
+    // Animate (progressive mode holds the view until every slice has been accumulated)
+    if (app.progressive_slices > 0)
+    {
+        app.progressive_slice = std::min(app.progressive_slice + 1, app.progressive_slices);
+        if (app.progressive_slice < app.progressive_slices)
+        {
+            app.frame_count++;
+            return;
+        }
+    }
     app.rotate_y -= 2.0;
     app.model_matrix = glm::translate(glm::dmat4(1.0), app.scene.pointcloud_center);
     app.model_matrix = glm::rotate(app.model_matrix, glm::radians(23.5), glm::dvec3(1.0, 0.0, 0.0));
@@ -463,8 +1096,8 @@ void doFrame()
 
     float mat4_model[16];
     mat4ToFloatArray(app.model_matrix, mat4_model);
-    glUseProgram(app.glsl_program["pointcloud"].program);
-    glUniformMatrix4fv(app.glsl_program["pointcloud"].uniforms["model_matrix"], 1, GL_FALSE, mat4_model);
+    glUseProgram(app.pointcloud_program->program);
+    glUniformMatrix4fv(app.pointcloud_program->uniforms["model_matrix"], 1, GL_FALSE, mat4_model);
     glUseProgram(0);
 
     app.frame_count++;
@@ -473,6 +1106,12 @@ void doFrame()
 void renderIceTOGL3(const IceTDouble *projection_matrix, const IceTDouble *modelview_matrix,
                     const IceTInt *readback_viewport, IceTUInt framebuffer_id)
 {
+    if (app.progressive_slices > 0)
+    {
+        renderProgressive(framebuffer_id);
+        return;
+    }
+
     // Render to IceT framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
 
@@ -487,14 +1126,21 @@ void renderIceTGeneric(const IceTDouble *projection_matrix, const IceTDouble *mo
                        const IceTFloat *background_color, const IceTInt *readback_viewport,
                        IceTImage result)
 {
-    // Render to app's framebuffer
-    glBindFramebuffer(GL_FRAMEBUFFER, app.framebuffer);
+    if (app.progressive_slices > 0)
+    {
+        renderProgressive(app.framebuffer);
+    }
+    else
+    {
+        // Render to app's framebuffer
+        glBindFramebuffer(GL_FRAMEBUFFER, app.framebuffer);
 
-    // Render
-    render();
+        // Render
+        render();
 
-    // Deselect app's framebuffer
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // Deselect app's framebuffer
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
 
     // Copy image to IceT buffer
     glFinish();
@@ -520,18 +1166,77 @@ void render()
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // Select shader program to use
-    glUseProgram(app.glsl_program["pointcloud"].program);
+    glUseProgram(app.pointcloud_program->program);
 
-    // Render
-    glBindVertexArray(app.scene.pointcloud_vertex_array);
-    glDrawElementsInstanced(GL_TRIANGLES, app.scene.pointcloud_face_index_count, GL_UNSIGNED_SHORT,
-                            0, app.scene.num_points);
+    // Render chunks (nearest first so early depth testing rejects hidden splats)
+    int i;
+    if (app.conservative_depth)
+    {
+        sortChunksFrontToBack();
+    }
+    glBindVertexArray(app.point_sprites ? app.scene.pointcloud_sprite_vertex_array : app.scene.pointcloud_vertex_array);
+    for (i = 0; i < app.scene.chunk_order.size(); i++)
+    {
+        drawPointChunk(&(app.scene.chunks[app.scene.chunk_order[i]]));
+    }
     glBindVertexArray(0);
 
     // Deseclect shader program
     glUseProgram(0);
 }
 
+void renderProgressive(GLuint framebuffer)
+{
+    // Add the next slice of every chunk to the accumulation buffer
+    glBindFramebuffer(GL_FRAMEBUFFER, app.accumulation_framebuffer);
+    if (app.progressive_slice == 0)
+    {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    if (app.progressive_slice < app.progressive_slices)
+    {
+        glUseProgram(app.pointcloud_program->program);
+        int i;
+        if (app.conservative_depth)
+        {
+            sortChunksFrontToBack();
+        }
+        glBindVertexArray(app.point_sprites ? app.scene.pointcloud_sprite_vertex_array : app.scene.pointcloud_vertex_array);
+        for (i = 0; i < app.scene.chunk_order.size(); i++)
+        {
+            // Chunks are randomly permuted, so each slice is a uniform subsample
+            PointChunk slice = app.scene.chunks[app.scene.chunk_order[i]];
+            uint32_t begin = (uint64_t)slice.count * app.progressive_slice / app.progressive_slices;
+            uint32_t end = (uint64_t)slice.count * (app.progressive_slice + 1) / app.progressive_slices;
+            slice.first += begin;
+            slice.draw_count = end - begin;
+            drawPointChunk(&slice);
+        }
+        glBindVertexArray(0);
+    }
+
+    // Copy color and depth of the accumulated image into the (IceT) framebuffer
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glDisable(GL_BLEND);
+    glDepthFunc(GL_ALWAYS);
+    glUseProgram(app.glsl_program["resolve"].program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, app.accumulation_texture);
+    glUniform1i(app.glsl_program["resolve"].uniforms["image"], 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, app.accumulation_depth);
+    glUniform1i(app.glsl_program["resolve"].uniforms["depth_buffer"], 1);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(app.resolve_vertex_array);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+    glDepthFunc(GL_LESS);
+    glEnable(GL_BLEND);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
 void display()
 {
     glClearColor(0.235, 0.235, 0.235, 1.000);
@@ -633,18 +1338,19 @@ void mat4ToFloatArray(glm::dmat4 mat4, float array[16])
     array[15] = mat4[3][3];
 }
 
-void loadPointCloudShader()
+void loadPointCloudShader(const char *defines)
 {
     // Compile GPU program
     GlslProgram p;
     p.program = glsl::createShaderProgram("resrc/shaders/pointcloud_color.vert",
-                                          "resrc/shaders/pointcloud_color.frag");
+                                          "resrc/shaders/pointcloud_color.frag", defines);
 
     // Specify input and output attributes for the GPU program
     glBindAttribLocation(p.program, app.vertex_position_attrib, "vertex_position");
     glBindAttribLocation(p.program, app.vertex_texcoord_attrib, "vertex_texcoord");
     glBindAttribLocation(p.program, app.point_center_attrib, "point_center");
     glBindAttribLocation(p.program, app.point_color_attrib, "point_color");
+    glBindAttribLocation(p.program, app.point_size_attrib, "point_size");
     glBindFragDataLocation(p.program, 0, "FragColor");
 
     // Link compiled GPU program
@@ -655,6 +1361,7 @@ void loadPointCloudShader()
 
     // Store GPU program and uniforms
     app.glsl_program["pointcloud"] = p;
+    app.pointcloud_program = &(app.glsl_program["pointcloud"]);
 }
 
 void loadCompositeShader()
@@ -679,34 +1386,741 @@ void loadCompositeShader()
     app.glsl_program["nolight"] = p;
 }
 
+void loadResolveShader()
+{
+    // Compile GPU program (full-screen triangle, no vertex attributes)
+    GlslProgram p;
+    p.program = glsl::createShaderProgram("resrc/shaders/depth_resolve.vert",
+                                          "resrc/shaders/accumulation_resolve.frag");
+    glBindFragDataLocation(p.program, 0, "FragColor");
+
+    // Link compiled GPU program
+    glsl::linkShaderProgram(p.program);
+
+    // Get handles to uniform variables defined in the shaders
+    glsl::getShaderProgramUniforms(p.program, p.uniforms);
+
+    // Store GPU program and uniforms
+    app.glsl_program["resolve"] = p;
+}
+
 void loadPointCloudData(const char *filename, float bbox[6])
 {
-    const int CAMERA_POSITION = 0;
-    const int CAMERA_TARGET = 1;
-    const int LIGHT_COUNT = 2;
-    const int LIGHTS = 3;
-    const int POINT_COUNT = 4;
-    const int POINTS = 5;
+    GLfloat *point_centers, *point_colors, *point_sizes;
+    if (app.staging_mb > 0)
+    {
+        loadPointCloudDataStaged(filename, bbox);
+        return;
+    }
+    if (app.point_budget > 0)
+    {
+        loadPointCloudOctree(filename, bbox);
+        return;
+    }
+
+    // Time from the first rank starting to the last rank finishing
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
 
-    std::ifstream scene_file(filename, std::ios::binary);
-    if (!scene_file.is_open())
+    app.scene.chunked_file = isChunkedPointCloud(filename);
+    if (app.scene.chunked_file)
     {
-        fprintf(stderr, "Error: could not open Point Cloud Data file\n");
-        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        readChunkedPointCloud(filename, &point_centers, &point_colors, &point_sizes);
     }
-    std::string line;
-    int i;
-    int section = CAMERA_POSITION;
-    int light_idx = 0;
-    uint32_t total_points;
-    GLfloat *point_centers, *point_colors, *point_sizes;
-    while (section != POINTS)
+    else
     {
-        std::getline(scene_file, line);
-        std::istringstream iss(line);
-        uint32_t count;
-        float x, y, z, red, green, blue;
-        switch (section)
+        readPointCloud(filename, &point_centers, &point_colors, &point_sizes);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    app.data_read_time = MPI_Wtime() - start;
+
+    // Give each rank a spatially compact block (file order spreads every rank over the globe)
+    app.partition_time = 0.0;
+    if (app.spatial_partition)
+    {
+        start = MPI_Wtime();
+        partitionPointsSpatially(&point_centers, &point_colors, &point_sizes);
+        MPI_Barrier(MPI_COMM_WORLD);
+        app.partition_time = MPI_Wtime() - start;
+    }
+
+    /*
+    // ---------------------------------------------------------
+    printf("CAMERA: pos = (%.3f, %.3f, %.3f) target = (%.3f, %.3f, %.3f)\n",
+           app.scene.camera_position[0], app.scene.camera_position[1], app.scene.camera_position[2],
+           app.scene.camera_target[0], app.scene.camera_target[1], app.scene.camera_target[2]);
+    printf("LIGHTS (%d):\n", app.scene.num_lights);
+    for (int i = 0; i < app.scene.num_lights; i++)
+    {
+        printf("  pos = (%.3f, %.3f, %.3f) color = (%.3f, %.3f, %.3f)\n",
+               app.scene.light_positions[3 * i], app.scene.light_positions[3 * i + 1], app.scene.light_positions[3 * i + 2],
+               app.scene.light_colors[3 * i], app.scene.light_colors[3 * i + 1], app.scene.light_colors[3 * i + 2]);
+    }
+    printf("POINTS (%d):\n", app.scene.num_points);
+    for (int i = 0; i < app.scene.num_points; i++)
+    {
+        printf("  pos = (%.3f, %.3f, %.3f) color = (%.3f, %.3f, %.3f)\n",
+               point_centers[3 * i], point_centers[3 * i + 1], point_centers[3 * i + 2],
+               point_colors[3 * i], point_colors[3 * i + 1], point_colors[3 * i + 2]);
+    }
+    // ---------------------------------------------------------
+    */
+
+    // Group nearby points into chunks (drawn and ordered as units)
+    // Only modes that order, cull, thin, or quantize per chunk need compact chunks, so others skip the sort
+    bool spatial_chunks = app.conservative_depth || app.quantize || app.chunk_culling ||
+                          app.points_per_pixel > 0.0f || app.progressive_slices > 0;
+    if (spatial_chunks)
+    {
+        // The sort needs the bounds up front, otherwise they come from the chunk statistics pass
+        double statistics_start = MPI_Wtime();
+        computeBoundingBox(point_centers, app.scene.num_points, bbox);
+        app.statistics_time += MPI_Wtime() - statistics_start;
+        sortPointsSpatially(point_centers, point_colors, point_sizes, bbox);
+    }
+    createPointChunks(point_centers, point_colors, point_sizes);
+    if (!spatial_chunks)
+    {
+        chunksBoundingBox(bbox);
+    }
+    // Normal cones are built around the global center
+    computePointCloudCenter(bbox);
+    computeChunkCones();
+    if (app.points_per_pixel > 0.0f || app.progressive_slices > 0)
+    {
+        // Any run of a chunk is then a uniform subsample of it
+        permutePointChunks(point_centers, point_colors, point_sizes);
+    }
+
+    app.scene.pointcloud_vertex_array = createPointCloudVertexArray(point_centers, point_colors, point_sizes);
+    app.scene.pointcloud_sprite_vertex_array = createPointSpriteVertexArray();
+    delete[] point_centers;
+    delete[] point_colors;
+    delete[] point_sizes;
+}
+
+bool isChunkedPointCloud(const char *filename)
+{
+    // Chunked files start with the format's magic number (rank 0 checks)
+    int chunked = 0;
+    if (app.rank == 0)
+    {
+        char magic[4] = {0, 0, 0, 0};
+        std::ifstream scene_file(filename, std::ios::binary);
+        if (!scene_file.is_open())
+        {
+            fprintf(stderr, "Error: could not open Point Cloud Data file\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        scene_file.read(magic, 4);
+        chunked = (memcmp(magic, PCD_MAGIC, 4) == 0);
+    }
+    MPI_Bcast(&chunked, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    return chunked != 0;
+}
+
+bool isOctreePointCloud(const char *filename)
+{
+    // Octree files start with their own magic number (rank 0 checks)
+    int octree = 0;
+    if (app.rank == 0)
+    {
+        char magic[4] = {0, 0, 0, 0};
+        std::ifstream scene_file(filename, std::ios::binary);
+        if (!scene_file.is_open())
+        {
+            fprintf(stderr, "Error: could not open Point Cloud Data file\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        scene_file.read(magic, 4);
+        octree = (memcmp(magic, PCD_OCTREE_MAGIC, 4) == 0);
+    }
+    MPI_Bcast(&octree, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    return octree != 0;
+}
+
+void readPointCloud(const char *filename, GLfloat **point_centers, GLfloat **point_colors, GLfloat **point_sizes)
+{
+    // Text header followed by all centers, all colors, then all sizes
+    uint64_t total_points;
+    uint64_t data_offset;
+    std::ifstream scene_file;
+    if (!app.mpi_io || app.rank == 0)
+    {
+        scene_file.open(filename, std::ios::binary);
+        if (!scene_file.is_open())
+        {
+            fprintf(stderr, "Error: could not open Point Cloud Data file\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        total_points = readPointCloudHeader(scene_file);
+        data_offset = scene_file.tellg();
+    }
+    if (app.mpi_io)
+    {
+        // Only rank 0 parses the text header
+        broadcastPointCloudHeader(&total_points, &data_offset);
+        scene_file.close();
+    }
+
+    uint64_t points_per_rank = total_points / app.num_proc;
+    uint64_t extra_points = total_points % app.num_proc;
+    setRankPointCount((app.rank < (app.num_proc - 1)) ? points_per_rank : points_per_rank + extra_points);
+    *point_centers = new GLfloat[3 * (size_t)app.scene.num_points];
+    *point_colors = new GLfloat[3 * (size_t)app.scene.num_points];
+    *point_sizes = new GLfloat[app.scene.num_points];
+    uint64_t point_idx_start = app.rank * points_per_rank;
+    uint64_t point_idx_end = point_idx_start + app.scene.num_points;
+
+    if (app.mpi_io)
+    {
+        readPointsMpiIo(filename, data_offset, total_points, point_idx_start, *point_centers, *point_colors, *point_sizes);
+    }
+    else
+    {
+        // 64-bit offsets (32-bit byte offsets overflow in the hundreds of millions of points)
+        scene_file.seekg((std::streamoff)(point_idx_start * 3 * sizeof(GLfloat)), std::ios_base::cur);
+        scene_file.read((char*)(*point_centers), 3 * (uint64_t)app.scene.num_points * sizeof(GLfloat));
+        scene_file.seekg((std::streamoff)((total_points - point_idx_end) * 3 * sizeof(GLfloat)), std::ios_base::cur);
+
+        scene_file.seekg((std::streamoff)(point_idx_start * 3 * sizeof(GLfloat)), std::ios_base::cur);
+        scene_file.read((char*)(*point_colors), 3 * (uint64_t)app.scene.num_points * sizeof(GLfloat));
+        scene_file.seekg((std::streamoff)((total_points - point_idx_end) * 3 * sizeof(GLfloat)), std::ios_base::cur);
+
+        scene_file.seekg((std::streamoff)(point_idx_start * sizeof(GLfloat)), std::ios_base::cur);
+        scene_file.read((char*)(*point_sizes), (uint64_t)app.scene.num_points * sizeof(GLfloat));
+        if (!scene_file)
+        {
+            fprintf(stderr, "Error: Point Cloud Data file is truncated\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        scene_file.close();
+    }
+}
+
+void readChunkTable(const char *filename, std::ifstream &scene_file, std::vector<PcdChunk> &chunks,
+                    uint64_t *chunk_start, uint64_t *chunk_end)
+{
+    // Header and chunk table (only rank 0 reads them when using MPI-IO)
+    PcdHeader header;
+    if (!app.mpi_io || app.rank == 0)
+    {
+        scene_file.open(filename, std::ios::binary);
+        if (!scene_file.is_open())
+        {
+            fprintf(stderr, "Error: could not open Point Cloud Data file\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        scene_file.read((char*)&header, sizeof(PcdHeader));
+        if (!scene_file)
+        {
+            fprintf(stderr, "Error: Point Cloud Data file is truncated (header)\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        if (header.version != PCD_VERSION || header.num_lights > PCD_MAX_LIGHTS)
+        {
+            fprintf(stderr, "Error: unsupported Point Cloud Data file version\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        chunks.resize(header.num_chunks);
+        scene_file.read((char*)chunks.data(), header.num_chunks * sizeof(PcdChunk));
+        if (!scene_file)
+        {
+            fprintf(stderr, "Error: Point Cloud Data file is truncated (chunk table)\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        // Chunks are read with one int count call each (see readChunkSection)
+        uint64_t c;
+        for (c = 0; c < header.num_chunks; c++)
+        {
+            if (chunks[c].num_points > PCD_MAX_CHUNK_POINTS)
+            {
+                fprintf(stderr, "Error: chunk %llu has %llu points (at most %d per chunk)\n", (unsigned long long)c,
+                        (unsigned long long)chunks[c].num_points, PCD_MAX_CHUNK_POINTS);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+        }
+    }
+    if (app.mpi_io)
+    {
+        MPI_Bcast(&header, sizeof(PcdHeader), MPI_BYTE, 0, MPI_COMM_WORLD);
+        chunks.resize(header.num_chunks);
+        MPI_Bcast(chunks.data(), header.num_chunks * sizeof(PcdChunk), MPI_BYTE, 0, MPI_COMM_WORLD);
+        scene_file.close();
+    }
+
+    int i;
+    app.scene.camera_position = glm::vec3(header.camera_position[0], header.camera_position[1], header.camera_position[2]);
+    app.scene.camera_target = glm::vec3(header.camera_target[0], header.camera_target[1], header.camera_target[2]);
+    app.scene.num_lights = header.num_lights;
+    app.scene.light_positions = new GLfloat[3 * app.scene.num_lights];
+    app.scene.light_colors = new GLfloat[3 * app.scene.num_lights];
+    for (i = 0; i < app.scene.num_lights; i++)
+    {
+        memcpy(app.scene.light_positions + 3 * i, header.lights[i].position, 3 * sizeof(float));
+        memcpy(app.scene.light_colors + 3 * i, header.lights[i].color, 3 * sizeof(float));
+    }
+
+    // Each rank takes a contiguous range of whole chunks
+    uint64_t chunks_per_rank = header.num_chunks / app.num_proc;
+    uint64_t extra_chunks = header.num_chunks % app.num_proc;
+    *chunk_start = app.rank * chunks_per_rank;
+    *chunk_end = *chunk_start + ((app.rank < (app.num_proc - 1)) ? chunks_per_rank : chunks_per_rank + extra_chunks);
+}
+
+void readChunkedPointCloud(const char *filename, GLfloat **point_centers, GLfloat **point_colors, GLfloat **point_sizes)
+{
+    uint64_t c, chunk_start, chunk_end;
+    std::vector<PcdChunk> chunks;
+    std::ifstream scene_file;
+    readChunkTable(filename, scene_file, chunks, &chunk_start, &chunk_end);
+
+    uint64_t num_points = 0;
+    for (c = chunk_start; c < chunk_end; c++)
+    {
+        num_points += chunks[c].num_points;
+    }
+    setRankPointCount(num_points);
+    *point_centers = new GLfloat[3 * num_points];
+    *point_colors = new GLfloat[3 * num_points];
+    *point_sizes = new GLfloat[num_points];
+
+    MPI_File file;
+    if (app.mpi_io)
+    {
+        if (MPI_File_open(MPI_COMM_WORLD, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+        {
+            fprintf(stderr, "Error: could not open Point Cloud Data file\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    }
+    uint64_t point_idx = 0;
+    for (c = chunk_start; c < chunk_end; c++)
+    {
+        uint64_t count = chunks[c].num_points;
+        uint64_t offset = chunks[c].offset;
+        readChunkSection(scene_file, file, offset, *point_centers + 3 * point_idx, 3 * count);
+        readChunkSection(scene_file, file, offset + 3 * count * sizeof(GLfloat), *point_colors + 3 * point_idx, 3 * count);
+        readChunkSection(scene_file, file, offset + 6 * count * sizeof(GLfloat), *point_sizes + point_idx, count);
+        point_idx += count;
+    }
+    if (app.mpi_io)
+    {
+        MPI_File_close(&file);
+    }
+    else
+    {
+        scene_file.close();
+    }
+}
+
+void loadPointCloudDataStaged(const char *filename, float bbox[6])
+{
+    // Allocate the vertex buffers first, then stream file sections into them (host memory stays at the staging size)
+    int i;
+    std::vector<PointSection> sections;
+    std::ifstream scene_file;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+
+    app.scene.chunked_file = isChunkedPointCloud(filename);
+    if (app.scene.chunked_file)
+    {
+        uint64_t c, chunk_start, chunk_end;
+        std::vector<PcdChunk> chunks;
+        readChunkTable(filename, scene_file, chunks, &chunk_start, &chunk_end);
+        uint64_t point_idx = 0;
+        for (c = chunk_start; c < chunk_end; c++)
+        {
+            uint64_t count = chunks[c].num_points;
+            PointSection section;
+            section.offset = chunks[c].offset;
+            section.first = 3 * point_idx;
+            section.count = 3 * count;
+            sections.push_back(section);
+            section.offset += 3 * count * sizeof(GLfloat);
+            sections.push_back(section);
+            section.offset += 3 * count * sizeof(GLfloat);
+            section.first = point_idx;
+            section.count = count;
+            sections.push_back(section);
+            point_idx += count;
+        }
+        setRankPointCount(point_idx);
+    }
+    else
+    {
+        scene_file.open(filename, std::ios::binary);
+        if (!scene_file.is_open())
+        {
+            fprintf(stderr, "Error: could not open Point Cloud Data file\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        uint64_t total_points = readPointCloudHeader(scene_file);
+        uint64_t data_offset = scene_file.tellg();
+        uint64_t points_per_rank = total_points / app.num_proc;
+        uint64_t extra_points = total_points % app.num_proc;
+        setRankPointCount((app.rank < (app.num_proc - 1)) ? points_per_rank : points_per_rank + extra_points);
+        uint64_t point_idx_start = app.rank * points_per_rank;
+        PointSection section;
+        section.offset = data_offset + 3 * point_idx_start * sizeof(GLfloat);
+        section.first = 0;
+        section.count = 3 * (uint64_t)app.scene.num_points;
+        sections.push_back(section);
+        section.offset = data_offset + 3 * (total_points + point_idx_start) * sizeof(GLfloat);
+        sections.push_back(section);
+        section.offset = data_offset + (6 * total_points + point_idx_start) * sizeof(GLfloat);
+        section.count = app.scene.num_points;
+        sections.push_back(section);
+    }
+
+    // Empty vertex buffers of the final size
+    app.scene.pointcloud_vertex_array = createPointCloudVertexArray(NULL, NULL, NULL);
+    app.scene.pointcloud_sprite_vertex_array = createPointSpriteVertexArray();
+
+    // Chunks stay in file order (bounds are gathered while the centers stream through)
+    uint32_t p;
+    app.scene.chunks.clear();
+    app.scene.chunk_order.clear();
+    for (p = 0; p < app.scene.num_points; p += POINT_CHUNK_SIZE)
+    {
+        PointChunk chunk;
+        chunk.first = p;
+        chunk.count = std::min((uint32_t)POINT_CHUNK_SIZE, app.scene.num_points - p);
+        chunk.bbox_min = glm::vec3(9.9e12, 9.9e12, 9.9e12);
+        chunk.bbox_max = glm::vec3(-9.9e12, -9.9e12, -9.9e12);
+        chunk.draw_count = chunk.count;
+        chunk.max_size = 0.0f;
+        chunk.cone_cutoff = 2.0f;
+        app.scene.chunk_order.push_back(app.scene.chunks.size());
+        app.scene.chunks.push_back(chunk);
+    }
+
+    // Whole points per staging block (sections come in center, color, size triples)
+    app.scene.luminance_histogram.assign(LUMINANCE_BINS, 0);
+    app.scene.size_histogram.assign(SIZE_BINS, 0);
+    size_t staging_floats = (size_t)app.staging_mb * 1024 * 1024 / sizeof(GLfloat);
+    std::vector<GLfloat> staging(staging_floats - staging_floats % 3);
+    for (i = 0; i < sections.size(); i++)
+    {
+        sections[i].buffer = (i % 3 == 0) ? app.scene.point_center_buffer :
+                             (i % 3 == 1) ? app.scene.point_color_buffer : app.scene.point_size_buffer;
+        stagePointSection(scene_file, &(sections[i]), staging);
+    }
+    scene_file.close();
+
+    chunksBoundingBox(bbox);
+    computePointCloudCenter(bbox);
+    computeChunkCones();
+
+    app.scene.max_point_size = 0.0f;
+    for (i = 0; i < app.scene.chunks.size(); i++)
+    {
+        app.scene.max_point_size = std::max(app.scene.max_point_size, app.scene.chunks[i].max_size);
+    }
+
+    glFinish();
+    MPI_Barrier(MPI_COMM_WORLD);
+    app.data_read_time = MPI_Wtime() - start;
+    app.partition_time = 0.0;
+}
+
+void stagePointSection(std::ifstream &scene_file, const PointSection *section, std::vector<GLfloat> &staging)
+{
+    // Read through the staging buffer into a mapped range of the vertex buffer, one staging block at a time
+    // Chunk bounds, largest sizes, and histograms are gathered while each block is still in cache
+    // (mapped memory is write-combined and slow to read)
+    uint64_t i, j;
+    glBindBuffer(GL_ARRAY_BUFFER, section->buffer);
+    scene_file.seekg((std::streamoff)section->offset);
+    for (i = 0; i < section->count; i += staging.size())
+    {
+        uint64_t count = std::min((uint64_t)staging.size(), section->count - i);
+        GLvoid *mapped = glMapBufferRange(GL_ARRAY_BUFFER, (section->first + i) * sizeof(GLfloat), count * sizeof(GLfloat),
+                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if (mapped == NULL)
+        {
+            fprintf(stderr, "Error: could not map vertex buffer range for staging (%llu bytes)\n",
+                    (unsigned long long)(count * sizeof(GLfloat)));
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        scene_file.read((char*)staging.data(), count * sizeof(GLfloat));
+        if ((uint64_t)scene_file.gcount() != count * sizeof(GLfloat))
+        {
+            fprintf(stderr, "Error: Point Cloud Data file is truncated (read %llu of %llu bytes at offset %llu)\n",
+                    (unsigned long long)scene_file.gcount(), (unsigned long long)(count * sizeof(GLfloat)),
+                    (unsigned long long)(section->offset + i * sizeof(GLfloat)));
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        if (section->buffer == app.scene.point_size_buffer)
+        {
+            for (j = 0; j < count; j++)
+            {
+                PointChunk *chunk = &(app.scene.chunks[(section->first + i + j) / POINT_CHUNK_SIZE]);
+                chunk->max_size = std::max(chunk->max_size, staging[j]);
+                app.scene.size_histogram[sizeBin(staging[j])]++;
+            }
+        }
+        else if (section->buffer == app.scene.point_color_buffer)
+        {
+            for (j = 0; j < count; j += 3)
+            {
+                app.scene.luminance_histogram[luminanceBin(staging.data() + j)]++;
+            }
+        }
+        else
+        {
+            for (j = 0; j < count; j += 3)
+            {
+                glm::vec3 point = glm::vec3(staging[j], staging[j + 1], staging[j + 2]);
+                PointChunk *chunk = &(app.scene.chunks[(section->first + i + j) / 3 / POINT_CHUNK_SIZE]);
+                chunk->bbox_min = glm::min(chunk->bbox_min, point);
+                chunk->bbox_max = glm::max(chunk->bbox_max, point);
+            }
+        }
+        memcpy(mapped, staging.data(), count * sizeof(GLfloat));
+        if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE)
+        {
+            fprintf(stderr, "Error: vertex buffer contents lost while staging\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void loadPointCloudOctree(const char *filename, float bbox[6])
+{
+    // Only the node table stays on the host, node points are streamed from the file as the LOD selects them
+    int i, c;
+    uint64_t n, j;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+
+    app.scene.chunked_file = false;
+    app.scene.octree_file.open(filename, std::ios::binary);
+    if (!app.scene.octree_file.is_open())
+    {
+        fprintf(stderr, "Error: could not open Point Cloud Data file\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    PcdOctreeHeader header;
+    app.scene.octree_file.read((char*)&header, sizeof(PcdOctreeHeader));
+    if (!app.scene.octree_file)
+    {
+        fprintf(stderr, "Error: Point Cloud Data file is truncated (header)\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    if (header.version != PCD_OCTREE_VERSION || header.num_lights > PCD_MAX_LIGHTS ||
+        header.node_points != OCTREE_NODE_POINTS || header.num_nodes > INT_MAX)
+    {
+        fprintf(stderr, "Error: unsupported octree Point Cloud Data file version\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    std::vector<PcdOctreeNode> nodes(header.num_nodes);
+    app.scene.octree_file.read((char*)nodes.data(), header.num_nodes * sizeof(PcdOctreeNode));
+    if (!app.scene.octree_file)
+    {
+        fprintf(stderr, "Error: Point Cloud Data file is truncated (node table)\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    app.scene.camera_position = glm::vec3(header.camera_position[0], header.camera_position[1], header.camera_position[2]);
+    app.scene.camera_target = glm::vec3(header.camera_target[0], header.camera_target[1], header.camera_target[2]);
+    app.scene.num_lights = header.num_lights;
+    app.scene.light_positions = new GLfloat[3 * app.scene.num_lights];
+    app.scene.light_colors = new GLfloat[3 * app.scene.num_lights];
+    for (i = 0; i < app.scene.num_lights; i++)
+    {
+        memcpy(app.scene.light_positions + 3 * i, header.lights[i].position, 3 * sizeof(float));
+        memcpy(app.scene.light_colors + 3 * i, header.lights[i].color, 3 * sizeof(float));
+    }
+
+    // Each rank owns the nodes whose first point falls in its even share of the depth first point order
+    // (contiguous subtrees, so ranks stay spatially compact below the top levels)
+    uint64_t points_per_rank = header.num_points / app.num_proc;
+    uint64_t point_idx_start = app.rank * points_per_rank;
+    uint64_t point_idx_end = (app.rank < (app.num_proc - 1)) ? point_idx_start + points_per_rank : header.num_points;
+    uint64_t num_points = 0;
+    app.scene.octree.resize(header.num_nodes);
+    for (n = 0; n < header.num_nodes; n++)
+    {
+        if (nodes[n].num_points > OCTREE_NODE_POINTS)
+        {
+            fprintf(stderr, "Error: octree node %llu has %u points (at most %d per node)\n", (unsigned long long)n,
+                    nodes[n].num_points, OCTREE_NODE_POINTS);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        OctreeNode *node = &(app.scene.octree[n]);
+        node->offset = nodes[n].offset;
+        node->count = nodes[n].num_points;
+        node->bbox_min = glm::vec3(nodes[n].bbox_min[0], nodes[n].bbox_min[1], nodes[n].bbox_min[2]);
+        node->bbox_max = glm::vec3(nodes[n].bbox_max[0], nodes[n].bbox_max[1], nodes[n].bbox_max[2]);
+        for (c = 0; c < 8; c++)
+        {
+            node->children[c] = nodes[n].children[c];
+        }
+        node->owned = nodes[n].first_point >= point_idx_start && nodes[n].first_point < point_idx_end;
+        node->owned_subtree = node->owned;
+        node->slot = -1;
+        node->last_used = -1;
+        if (node->owned)
+        {
+            num_points += node->count;
+        }
+    }
+    // Children come after their parent, so one backward pass marks the subtrees to traverse
+    for (i = (int)header.num_nodes - 1; i >= 0; i--)
+    {
+        for (c = 0; c < 8; c++)
+        {
+            int child = app.scene.octree[i].children[c];
+            if (child >= 0 && app.scene.octree[child].owned_subtree)
+            {
+                app.scene.octree[i].owned_subtree = true;
+            }
+        }
+    }
+    setRankPointCount(num_points);
+    app.scene.octree_dropped_points = header.dropped_points;
+    if (app.scene.octree_dropped_points > 0 && app.rank == 0)
+    {
+        fprintf(stderr, "Warning: %llu coincident points exceed the octree depth (dropped by pcd_octree)\n",
+                (unsigned long long)app.scene.octree_dropped_points);
+    }
+
+    // Pool of node-sized GPU slots (room for the budget twice over, so nodes can stay cached)
+    int num_slots = 2 * ((app.point_budget + OCTREE_NODE_POINTS - 1) / OCTREE_NODE_POINTS) + 8;
+    app.scene.pool_slots.assign(num_slots, -1);
+    app.scene.pointcloud_vertex_array = createPointCloudVertexArray(NULL, NULL, NULL);
+    app.scene.pointcloud_sprite_vertex_array = createPointSpriteVertexArray();
+
+    // One pass over the owned nodes for the rank's bounds, largest size, and histograms (one node in memory at a time)
+    bbox[0] =  9.9e12; // x min
+    bbox[1] = -9.9e12; // x max
+    bbox[2] =  9.9e12; // y min
+    bbox[3] = -9.9e12; // y max
+    bbox[4] =  9.9e12; // z min
+    bbox[5] = -9.9e12; // z max
+    app.scene.max_point_size = 0.0f;
+    app.scene.luminance_histogram.assign(LUMINANCE_BINS, 0);
+    app.scene.size_histogram.assign(SIZE_BINS, 0);
+    app.scene.octree_staging.resize(7 * OCTREE_NODE_POINTS);
+    for (n = 0; n < header.num_nodes; n++)
+    {
+        const OctreeNode *node = &(app.scene.octree[n]);
+        if (!node->owned)
+        {
+            continue;
+        }
+        readOctreeNode(node);
+        const GLfloat *centers = app.scene.octree_staging.data();
+        const GLfloat *colors = centers + 3 * node->count;
+        const GLfloat *sizes = centers + 6 * node->count;
+        for (j = 0; j < node->count; j++)
+        {
+            bbox[0] = std::min(bbox[0], centers[3 * j]);
+            bbox[1] = std::max(bbox[1], centers[3 * j]);
+            bbox[2] = std::min(bbox[2], centers[3 * j + 1]);
+            bbox[3] = std::max(bbox[3], centers[3 * j + 1]);
+            bbox[4] = std::min(bbox[4], centers[3 * j + 2]);
+            bbox[5] = std::max(bbox[5], centers[3 * j + 2]);
+            app.scene.max_point_size = std::max(app.scene.max_point_size, sizes[j]);
+            app.scene.luminance_histogram[luminanceBin(colors + 3 * j)]++;
+            app.scene.size_histogram[sizeBin(sizes[j])]++;
+        }
+    }
+    computePointCloudCenter(bbox);
+    app.scene.chunks.clear();
+    app.scene.chunk_order.clear();
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    app.data_read_time = MPI_Wtime() - start;
+    app.partition_time = 0.0;
+}
+
+void readOctreeNode(const OctreeNode *node)
+{
+    // A node's centers, colors, and sizes are stored together (one read into the staging buffer)
+    uint64_t bytes = 7 * (uint64_t)node->count * sizeof(GLfloat);
+    app.scene.octree_file.seekg((std::streamoff)node->offset);
+    app.scene.octree_file.read((char*)app.scene.octree_staging.data(), bytes);
+    if ((uint64_t)app.scene.octree_file.gcount() != bytes)
+    {
+        fprintf(stderr, "Error: Point Cloud Data file is truncated (read %llu of %llu bytes at offset %llu)\n",
+                (unsigned long long)app.scene.octree_file.gcount(), (unsigned long long)bytes,
+                (unsigned long long)node->offset);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+}
+
+void readChunkSection(std::ifstream &scene_file, MPI_File file, uint64_t offset, GLfloat *buffer, uint64_t count)
+{
+    // Chunks are small enough for a single read (readChunkTable rejects larger ones)
+    uint64_t bytes_read;
+    if (app.mpi_io)
+    {
+        MPI_Status status;
+        int floats_read = 0;
+        if (MPI_File_read_at(file, (MPI_Offset)offset, buffer, (int)count, MPI_FLOAT, &status) == MPI_SUCCESS)
+        {
+            MPI_Get_count(&status, MPI_FLOAT, &floats_read);
+        }
+        bytes_read = std::max(floats_read, 0) * sizeof(GLfloat);
+    }
+    else
+    {
+        scene_file.seekg((std::streamoff)offset);
+        scene_file.read((char*)buffer, count * sizeof(GLfloat));
+        bytes_read = scene_file.gcount();
+    }
+    if (bytes_read != count * sizeof(GLfloat))
+    {
+        fprintf(stderr, "Error: Point Cloud Data file is truncated (read %llu of %llu bytes at offset %llu)\n",
+                (unsigned long long)bytes_read, (unsigned long long)(count * sizeof(GLfloat)),
+                (unsigned long long)offset);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+}
+
+void setRankPointCount(uint64_t num_points)
+{
+    // Per-rank point indices and draw counts are 32-bit
+    if (num_points > INT_MAX)
+    {
+        fprintf(stderr, "Error: rank %d would hold %llu points (at most %d per rank, use more ranks)\n", app.rank,
+                (unsigned long long)num_points, INT_MAX);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    app.scene.num_points = (int)num_points;
+}
+
+uint64_t readPointCloudHeader(std::ifstream &scene_file)
+{
+    // Text header: camera, lights, and point count (binary point data follows)
+    const int CAMERA_POSITION = 0;
+    const int CAMERA_TARGET = 1;
+    const int LIGHT_COUNT = 2;
+    const int LIGHTS = 3;
+    const int POINT_COUNT = 4;
+    const int POINTS = 5;
+
+    std::string line;
+    int section = CAMERA_POSITION;
+    int light_idx = 0;
+    uint64_t total_points;
+    while (section != POINTS)
+    {
+        std::getline(scene_file, line);
+        std::istringstream iss(line);
+        uint32_t count;
+        float x, y, z, red, green, blue;
+        switch (section)
         {
             case CAMERA_POSITION:
                 iss >> x >> y >> z;
@@ -736,81 +2150,935 @@ void loadPointCloudData(const char *filename, float bbox[6])
                 light_idx++;
                 if (light_idx >= app.scene.num_lights)
                 {
-                    section = POINT_COUNT;
+                    section = POINT_COUNT;
+                }
+                break;
+            case POINT_COUNT:
+                iss >> total_points;
+                section = POINTS;
+                break;
+        }
+    }
+    return total_points;
+}
+
+void broadcastPointCloudHeader(uint64_t *total_points, uint64_t *data_offset)
+{
+    // Share rank 0's parsed header with all other ranks
+    float camera[6];
+    if (app.rank == 0)
+    {
+        memcpy(camera, glm::value_ptr(app.scene.camera_position), 3 * sizeof(float));
+        memcpy(camera + 3, glm::value_ptr(app.scene.camera_target), 3 * sizeof(float));
+    }
+    MPI_Bcast(camera, 6, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&(app.scene.num_lights), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (app.rank != 0)
+    {
+        app.scene.camera_position = glm::vec3(camera[0], camera[1], camera[2]);
+        app.scene.camera_target = glm::vec3(camera[3], camera[4], camera[5]);
+        app.scene.light_positions = new GLfloat[3 * app.scene.num_lights];
+        app.scene.light_colors = new GLfloat[3 * app.scene.num_lights];
+    }
+    MPI_Bcast(app.scene.light_positions, 3 * app.scene.num_lights, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(app.scene.light_colors, 3 * app.scene.num_lights, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(total_points, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    MPI_Bcast(data_offset, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+}
+
+void readPointsMpiIo(const char *filename, uint64_t data_offset, uint64_t total_points, uint64_t point_idx_start,
+                     GLfloat *point_centers, GLfloat *point_colors, GLfloat *point_sizes)
+{
+    // Collective buffering lets a few aggregator ranks issue large contiguous reads
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "romio_cb_read", "enable");
+    MPI_Info_set(info, "cb_buffer_size", "16777216");
+
+    MPI_File file;
+    if (MPI_File_open(MPI_COMM_WORLD, filename, MPI_MODE_RDONLY, info, &file) != MPI_SUCCESS)
+    {
+        fprintf(stderr, "Error: could not open Point Cloud Data file\n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // Last rank holds the most points, so it sets the number of collective calls
+    uint64_t max_points = total_points / app.num_proc + total_points % app.num_proc;
+    MPI_Offset centers_offset = data_offset;
+    MPI_Offset colors_offset = centers_offset + 3 * (MPI_Offset)total_points * sizeof(GLfloat);
+    MPI_Offset sizes_offset = colors_offset + 3 * (MPI_Offset)total_points * sizeof(GLfloat);
+    readAtAll(file, centers_offset + 3 * (MPI_Offset)point_idx_start * sizeof(GLfloat), point_centers,
+              3 * (uint64_t)app.scene.num_points, 3 * max_points);
+    readAtAll(file, colors_offset + 3 * (MPI_Offset)point_idx_start * sizeof(GLfloat), point_colors,
+              3 * (uint64_t)app.scene.num_points, 3 * max_points);
+    readAtAll(file, sizes_offset + (MPI_Offset)point_idx_start * sizeof(GLfloat), point_sizes,
+              (uint64_t)app.scene.num_points, max_points);
+
+    MPI_File_close(&file);
+    MPI_Info_free(&info);
+}
+
+void readAtAll(MPI_File file, MPI_Offset offset, GLfloat *buffer, uint64_t count, uint64_t max_count)
+{
+    // Split into blocks that fit an int count (every rank makes the same number of calls)
+    uint64_t i;
+    for (i = 0; i < max_count; i += MPI_IO_BLOCK_SIZE)
+    {
+        int block = (i < count) ? (int)std::min(count - i, (uint64_t)MPI_IO_BLOCK_SIZE) : 0;
+        MPI_Status status;
+        int floats_read = 0;
+        if (MPI_File_read_at_all(file, offset + (MPI_Offset)i * sizeof(GLfloat), buffer + i, block, MPI_FLOAT,
+                                 &status) == MPI_SUCCESS)
+        {
+            MPI_Get_count(&status, MPI_FLOAT, &floats_read);
+        }
+        if (floats_read != block)
+        {
+            fprintf(stderr, "Error: Point Cloud Data file is truncated (read %d of %d values)\n", floats_read, block);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    }
+}
+
+void partitionPointsSpatially(GLfloat **point_centers, GLfloat **point_colors, GLfloat **point_sizes)
+{
+    // Split the global Morton curve into one contiguous range per rank
+    uint32_t i;
+    int r;
+    uint32_t num_points = app.scene.num_points;
+    float local_bbox[6], bbox[6];
+    computeBoundingBox(*point_centers, num_points, local_bbox);
+    for (i = 0; i < 3; i++)
+    {
+        MPI_Allreduce(&(local_bbox[2 * i]), &(bbox[2 * i]), 1, MPI_FLOAT, MPI_MIN, MPI_COMM_WORLD);
+        MPI_Allreduce(&(local_bbox[2 * i + 1]), &(bbox[2 * i + 1]), 1, MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD);
+    }
+
+    // Global histogram of the leading Morton code bits
+    int num_buckets = 1 << PARTITION_BUCKET_BITS;
+    std::vector<uint32_t> bucket(num_points);
+    std::vector<uint64_t> histogram(num_buckets, 0);
+    std::vector<uint64_t> global_histogram(num_buckets);
+    for (i = 0; i < num_points; i++)
+    {
+        bucket[i] = mortonCode(*point_centers + 3 * i, bbox) >> (30 - PARTITION_BUCKET_BITS);
+        histogram[bucket[i]]++;
+    }
+    MPI_Allreduce(histogram.data(), global_histogram.data(), num_buckets, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    // Consecutive buckets go to the same rank until it has its share of points
+    uint64_t total_points = 0;
+    for (i = 0; i < num_buckets; i++)
+    {
+        total_points += global_histogram[i];
+    }
+    std::vector<int> destination(num_buckets);
+    uint64_t prefix = 0;
+    for (i = 0; i < num_buckets; i++)
+    {
+        uint64_t middle = prefix + global_histogram[i] / 2;
+        destination[i] = std::min((int)(middle * app.num_proc / std::max(total_points, (uint64_t)1)), app.num_proc - 1);
+        prefix += global_histogram[i];
+    }
+
+    // Pack points by destination (records of 7 floats: center, color, size)
+    // Counts and offsets are in records, so they stay within an int for any per-rank point count
+    MPI_Datatype point_record;
+    MPI_Type_contiguous(7, MPI_FLOAT, &point_record);
+    MPI_Type_commit(&point_record);
+    std::vector<int> send_counts(app.num_proc, 0);
+    std::vector<int> send_offsets(app.num_proc, 0);
+    std::vector<int> recv_counts(app.num_proc);
+    std::vector<int> recv_offsets(app.num_proc, 0);
+    for (i = 0; i < num_points; i++)
+    {
+        send_counts[destination[bucket[i]]]++;
+    }
+    for (r = 1; r < app.num_proc; r++)
+    {
+        send_offsets[r] = send_offsets[r - 1] + send_counts[r - 1];
+    }
+    std::vector<GLfloat> send_buffer(7 * (size_t)num_points);
+    std::vector<int> position = send_offsets;
+    for (i = 0; i < num_points; i++)
+    {
+        GLfloat *point = send_buffer.data() + 7 * (size_t)position[destination[bucket[i]]];
+        memcpy(point, *point_centers + 3 * (size_t)i, 3 * sizeof(GLfloat));
+        memcpy(point + 3, *point_colors + 3 * (size_t)i, 3 * sizeof(GLfloat));
+        point[6] = (*point_sizes)[i];
+        position[destination[bucket[i]]]++;
+    }
+    delete[] *point_centers;
+    delete[] *point_colors;
+    delete[] *point_sizes;
+
+    // Exchange (the received total is checked before it is used as an int offset)
+    MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    uint64_t recv_points = 0;
+    for (r = 0; r < app.num_proc; r++)
+    {
+        recv_points += recv_counts[r];
+    }
+    setRankPointCount(recv_points);
+    num_points = recv_points;
+    for (r = 1; r < app.num_proc; r++)
+    {
+        recv_offsets[r] = recv_offsets[r - 1] + recv_counts[r - 1];
+    }
+    std::vector<GLfloat> recv_buffer(7 * (size_t)num_points);
+    MPI_Alltoallv(send_buffer.data(), send_counts.data(), send_offsets.data(), point_record,
+                  recv_buffer.data(), recv_counts.data(), recv_offsets.data(), point_record, MPI_COMM_WORLD);
+    std::vector<GLfloat>().swap(send_buffer);
+    MPI_Type_free(&point_record);
+
+    // Unpack
+    *point_centers = new GLfloat[3 * (size_t)num_points];
+    *point_colors = new GLfloat[3 * (size_t)num_points];
+    *point_sizes = new GLfloat[num_points];
+    for (i = 0; i < num_points; i++)
+    {
+        const GLfloat *point = recv_buffer.data() + 7 * (size_t)i;
+        memcpy(*point_centers + 3 * (size_t)i, point, 3 * sizeof(GLfloat));
+        memcpy(*point_colors + 3 * (size_t)i, point + 3, 3 * sizeof(GLfloat));
+        (*point_sizes)[i] = point[6];
+    }
+}
+
+void computePointCloudCenter(const float bbox[6])
+{
+    // Center of the global bounding box (the globe's center, used as the model rotation pivot)
+    float x_min, y_min, z_min, x_max, y_max, z_max;
+    MPI_Allreduce(&(bbox[0]), &x_min, 1, MPI_FLOAT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(&(bbox[2]), &y_min, 1, MPI_FLOAT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(&(bbox[4]), &z_min, 1, MPI_FLOAT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(&(bbox[1]), &x_max, 1, MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(&(bbox[3]), &y_max, 1, MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(&(bbox[5]), &z_max, 1, MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD);
+    app.scene.pointcloud_center = glm::vec3((x_min + x_max) / 2.0, (y_min + y_max) / 2.0, (z_min + z_max) / 2.0);
+}
+
+void chunksBoundingBox(float bbox[6])
+{
+    // Rank's bounds as the union of the chunk bounds
+    uint32_t i;
+    bbox[0] =  9.9e12; // x min
+    bbox[1] = -9.9e12; // x max
+    bbox[2] =  9.9e12; // y min
+    bbox[3] = -9.9e12; // y max
+    bbox[4] =  9.9e12; // z min
+    bbox[5] = -9.9e12; // z max
+    for (i = 0; i < app.scene.chunks.size(); i++)
+    {
+        bbox[0] = std::min(bbox[0], app.scene.chunks[i].bbox_min.x);
+        bbox[1] = std::max(bbox[1], app.scene.chunks[i].bbox_max.x);
+        bbox[2] = std::min(bbox[2], app.scene.chunks[i].bbox_min.y);
+        bbox[3] = std::max(bbox[3], app.scene.chunks[i].bbox_max.y);
+        bbox[4] = std::min(bbox[4], app.scene.chunks[i].bbox_min.z);
+        bbox[5] = std::max(bbox[5], app.scene.chunks[i].bbox_max.z);
+    }
+}
+
+void computeBoundingBox(const GLfloat *point_centers, uint32_t num_points, float bbox[6])
+{
+    // Each thread reduces a contiguous range, then the ranges are combined
+    int t, axis;
+    int num_threads = app.num_threads;
+    std::vector<float> bounds_min(3 * num_threads);
+    std::vector<float> bounds_max(3 * num_threads);
+    std::vector<std::thread> threads;
+    uint32_t per_thread = (num_points + num_threads - 1) / num_threads;
+    for (t = 0; t < num_threads; t++)
+    {
+        uint32_t begin = std::min((uint64_t)t * per_thread, (uint64_t)num_points);
+        uint32_t end = std::min((uint64_t)begin + per_thread, (uint64_t)num_points);
+        threads.push_back(std::thread(pointBounds, point_centers + 3 * (size_t)begin, end - begin,
+                                      bounds_min.data() + 3 * t, bounds_max.data() + 3 * t));
+    }
+    for (t = 0; t < num_threads; t++)
+    {
+        threads[t].join();
+    }
+
+    for (axis = 0; axis < 3; axis++)
+    {
+        bbox[2 * axis] = bounds_min[axis];
+        bbox[2 * axis + 1] = bounds_max[axis];
+        for (t = 1; t < num_threads; t++)
+        {
+            bbox[2 * axis] = std::min(bbox[2 * axis], bounds_min[3 * t + axis]);
+            bbox[2 * axis + 1] = std::max(bbox[2 * axis + 1], bounds_max[3 * t + axis]);
+        }
+    }
+}
+
+void pointBounds(const GLfloat *point_centers, uint32_t num_points, float bounds_min[3], float bounds_max[3])
+{
+    // Min/max of interleaved xyz positions
+    uint32_t i = 0;
+    int axis;
+    for (axis = 0; axis < 3; axis++)
+    {
+        bounds_min[axis] =  9.9e12;
+        bounds_max[axis] = -9.9e12;
+    }
+#ifdef POINT_BOUNDS_AVX2
+    if (app.avx2)
+    {
+        i = pointBoundsAvx2(point_centers, num_points, bounds_min, bounds_max);
+    }
+#endif
+    for (; i < num_points; i++)
+    {
+        for (axis = 0; axis < 3; axis++)
+        {
+            bounds_min[axis] = std::min(bounds_min[axis], point_centers[3 * i + axis]);
+            bounds_max[axis] = std::max(bounds_max[axis], point_centers[3 * i + axis]);
+        }
+    }
+}
+
+#ifdef POINT_BOUNDS_AVX2
+__attribute__((target("avx2")))
+uint32_t pointBoundsAvx2(const GLfloat *point_centers, uint32_t num_points, float bounds_min[3], float bounds_max[3])
+{
+    // 8 points (24 floats) per step, so each lane of the three registers always holds the same axis
+    uint32_t i;
+    int r, lane;
+    __m256 lo[3], hi[3];
+    for (r = 0; r < 3; r++)
+    {
+        lo[r] = _mm256_set1_ps(9.9e12f);
+        hi[r] = _mm256_set1_ps(-9.9e12f);
+    }
+    uint32_t vector_points = num_points & ~7u;
+    for (i = 0; i < vector_points; i += 8)
+    {
+        const float *points = point_centers + 3 * (size_t)i;
+        for (r = 0; r < 3; r++)
+        {
+            __m256 v = _mm256_loadu_ps(points + 8 * r);
+            lo[r] = _mm256_min_ps(lo[r], v);
+            hi[r] = _mm256_max_ps(hi[r], v);
+        }
+    }
+
+    float lo_lanes[24], hi_lanes[24];
+    for (r = 0; r < 3; r++)
+    {
+        _mm256_storeu_ps(lo_lanes + 8 * r, lo[r]);
+        _mm256_storeu_ps(hi_lanes + 8 * r, hi[r]);
+    }
+    for (lane = 0; lane < 24; lane++)
+    {
+        bounds_min[lane % 3] = std::min(bounds_min[lane % 3], lo_lanes[lane]);
+        bounds_max[lane % 3] = std::max(bounds_max[lane % 3], hi_lanes[lane]);
+    }
+    return vector_points;
+}
+#endif
+
+void updateOctreeLod()
+{
+    // Refine the visible nodes with the largest projected size first, until the point budget is spent
+    // (nodes outside the frustum are never queued, so they take no budget, loads, or pool slots)
+    if (app.scene.octree.empty())
+    {
+        return;
+    }
+    glm::dvec4 camera = glm::inverse(app.model_matrix) * glm::dvec4(glm::dvec3(app.scene.camera_position), 1.0);
+    glm::vec3 eye = glm::vec3(camera.x, camera.y, camera.z);
+    float pixels_per_unit = app.projection_matrix[1][1] * 0.5 * app.window_height;
+    glm::vec4 planes[6];
+    frustumPlanes(app.projection_matrix * app.view_matrix * app.model_matrix, planes);
+    float half_size = 0.5f * app.scene.max_point_size;
+    glm::vec3 pad = glm::vec3(half_size, half_size, half_size);
+
+    std::priority_queue<std::pair<float, int> > queue;
+    if (app.scene.octree[0].owned_subtree &&
+        !boxOutsideFrustum(planes, app.scene.octree[0].bbox_min - pad, app.scene.octree[0].bbox_max + pad))
+    {
+        queue.push(std::make_pair(1.0e30f, 0));
+    }
+    app.scene.chunks.clear();
+    app.scene.chunk_order.clear();
+    int c;
+    int loads = 0;
+    uint32_t points = 0;
+    while (!queue.empty())
+    {
+        int node_idx = queue.top().second;
+        queue.pop();
+        OctreeNode *node = &(app.scene.octree[node_idx]);
+
+        // Other ranks' nodes are only passed through on the way to this rank's subtrees
+        if (node->owned)
+        {
+            if (points + node->count > app.point_budget)
+            {
+                break;
+            }
+
+            // Stream in missing nodes (a limited number per frame, the rest wait for later frames)
+            if (node->slot < 0)
+            {
+                if (loads >= OCTREE_LOADS_PER_FRAME || !loadOctreeNode(node_idx))
+                {
+                    continue;
                 }
-                break;
-            case POINT_COUNT:
-                iss >> count;
-                total_points = count;
-                section = POINTS;
-                break;
+                loads++;
+            }
+            node->last_used = app.frame_count;
+            points += node->count;
+
+            PointChunk chunk;
+            chunk.first = node->slot * OCTREE_NODE_POINTS;
+            chunk.count = node->count;
+            chunk.bbox_min = node->bbox_min;
+            chunk.bbox_max = node->bbox_max;
+            chunk.draw_count = chunk.count;
+            chunk.max_size = app.scene.max_point_size;
+            chunk.cone_cutoff = 2.0f;
+            app.scene.chunk_order.push_back(app.scene.chunks.size());
+            app.scene.chunks.push_back(chunk);
+        }
+
+        for (c = 0; c < 8; c++)
+        {
+            if (node->children[c] >= 0)
+            {
+                OctreeNode *child = &(app.scene.octree[node->children[c]]);
+                if (!child->owned_subtree || boxOutsideFrustum(planes, child->bbox_min - pad, child->bbox_max + pad))
+                {
+                    continue;
+                }
+                glm::vec3 center = 0.5f * (child->bbox_min + child->bbox_max);
+                float radius = 0.5f * glm::length(child->bbox_max - child->bbox_min);
+                float distance = std::max(glm::length(center - eye) - radius, 1.0e-6f);
+                float projected = radius / distance * pixels_per_unit;
+                if (projected >= OCTREE_MIN_NODE_PIXELS)
+                {
+                    queue.push(std::make_pair(projected, node->children[c]));
+                }
+            }
         }
     }
+    app.lod_drawn_points += points;
+    app.lod_loaded_nodes += loads;
+}
 
-    uint32_t points_per_rank = total_points / app.num_proc;
-    uint32_t extra_points = total_points % app.num_proc;
-    app.scene.num_points = (app.rank < (app.num_proc - 1)) ? points_per_rank : points_per_rank + extra_points;
-    point_centers = new GLfloat[3 * app.scene.num_points];
-    point_colors = new GLfloat[3 * app.scene.num_points];
-    point_sizes = new GLfloat[app.scene.num_points];
-    uint32_t point_idx_start = app.rank * points_per_rank;
-    uint32_t point_idx_end = point_idx_start + app.scene.num_points;
+bool loadOctreeNode(int node_idx)
+{
+    // Use a free slot, or evict the least recently used node not drawn this frame
+    int i;
+    int slot = -1;
+    int oldest = app.frame_count;
+    for (i = 0; i < app.scene.pool_slots.size(); i++)
+    {
+        int resident = app.scene.pool_slots[i];
+        if (resident < 0)
+        {
+            slot = i;
+            break;
+        }
+        if (app.scene.octree[resident].last_used < oldest)
+        {
+            oldest = app.scene.octree[resident].last_used;
+            slot = i;
+        }
+    }
+    if (slot < 0)
+    {
+        return false;
+    }
+    if (app.scene.pool_slots[slot] >= 0)
+    {
+        app.scene.octree[app.scene.pool_slots[slot]].slot = -1;
+    }
 
-    scene_file.seekg(point_idx_start * 3 * sizeof(GLfloat), std::ios_base::cur);
-    scene_file.read((char*)point_centers, 3 * app.scene.num_points * sizeof(GLfloat));
-    scene_file.seekg((total_points - point_idx_end) * 3 * sizeof(GLfloat), std::ios_base::cur);
+    // Read the node from the octree file, then copy it into the slot
+    OctreeNode *node = &(app.scene.octree[node_idx]);
+    readOctreeNode(node);
+    const GLfloat *centers = app.scene.octree_staging.data();
+    size_t offset = (size_t)slot * OCTREE_NODE_POINTS;
+    glBindBuffer(GL_ARRAY_BUFFER, app.scene.point_center_buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 3 * offset * sizeof(GLfloat), 3 * node->count * sizeof(GLfloat), centers);
+    glBindBuffer(GL_ARRAY_BUFFER, app.scene.point_color_buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 3 * offset * sizeof(GLfloat), 3 * node->count * sizeof(GLfloat),
+                    centers + 3 * node->count);
+    glBindBuffer(GL_ARRAY_BUFFER, app.scene.point_size_buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(GLfloat), node->count * sizeof(GLfloat), centers + 6 * node->count);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    scene_file.seekg(point_idx_start * 3 * sizeof(GLfloat), std::ios_base::cur);
-    scene_file.read((char*)point_colors, 3 * app.scene.num_points * sizeof(GLfloat));
-    scene_file.seekg((total_points - point_idx_end) * 3 * sizeof(GLfloat), std::ios_base::cur);
+    node->slot = slot;
+    app.scene.pool_slots[slot] = node_idx;
+    return true;
+}
 
-    scene_file.seekg(point_idx_start * sizeof(GLfloat), std::ios_base::cur);
-    scene_file.read((char*)point_sizes, app.scene.num_points * sizeof(GLfloat));
+void sortPointsSpatially(GLfloat *point_centers, GLfloat *point_colors, GLfloat *point_sizes, const float bbox[6])
+{
+    // Reorder points along a Morton curve so consecutive points are spatially close
+    uint32_t i;
+    uint32_t num_points = app.scene.num_points;
+    std::vector<uint64_t> keys(num_points);
+    for (i = 0; i < num_points; i++)
+    {
+        keys[i] = ((uint64_t)mortonCode(point_centers + 3 * i, bbox) << 32) | i;
+    }
+    std::sort(keys.begin(), keys.end());
 
-    scene_file.close();
+    std::vector<GLfloat> sorted(3 * num_points);
+    for (i = 0; i < num_points; i++)
+    {
+        memcpy(sorted.data() + 3 * i, point_centers + 3 * (keys[i] & 0xFFFFFFFF), 3 * sizeof(GLfloat));
+    }
+    memcpy(point_centers, sorted.data(), 3 * num_points * sizeof(GLfloat));
+    for (i = 0; i < num_points; i++)
+    {
+        memcpy(sorted.data() + 3 * i, point_colors + 3 * (keys[i] & 0xFFFFFFFF), 3 * sizeof(GLfloat));
+    }
+    memcpy(point_colors, sorted.data(), 3 * num_points * sizeof(GLfloat));
+    for (i = 0; i < num_points; i++)
+    {
+        sorted[i] = point_sizes[keys[i] & 0xFFFFFFFF];
+    }
+    memcpy(point_sizes, sorted.data(), num_points * sizeof(GLfloat));
+}
 
-    bbox[0] =  9.9e12; // x min
-    bbox[1] = -9.9e12; // x max
-    bbox[2] =  9.9e12; // y min
-    bbox[3] = -9.9e12; // y max
-    bbox[4] =  9.9e12; // z min
-    bbox[5] = -9.9e12; // z max
-    for (i = 0; i < app.scene.num_points; i++)
+uint32_t mortonCode(const GLfloat *point, const float bbox[6])
+{
+    // Interleave 10 bits per axis of the point's position in the bounding box
+    int i, axis;
+    uint32_t code = 0;
+    uint32_t cell[3];
+    for (axis = 0; axis < 3; axis++)
+    {
+        float extent = bbox[2 * axis + 1] - bbox[2 * axis];
+        float t = (extent > 0.0f) ? (point[axis] - bbox[2 * axis]) / extent : 0.0f;
+        cell[axis] = std::min(std::max((int)(t * 1024.0f), 0), 1023);
+    }
+    for (i = 0; i < 10; i++)
+    {
+        for (axis = 0; axis < 3; axis++)
+        {
+            code |= ((cell[axis] >> i) & 1) << (3 * i + (2 - axis));
+        }
+    }
+    return code;
+}
+
+void createPointChunks(const GLfloat *point_centers, const GLfloat *point_colors, const GLfloat *point_sizes)
+{
+    // Fixed-size runs of the sorted points, with bounds and histograms gathered in one threaded pass
+    uint32_t i;
+    int t;
+    double start = MPI_Wtime();
+    app.scene.chunks.clear();
+    app.scene.chunk_order.clear();
+    for (i = 0; i < app.scene.num_points; i += POINT_CHUNK_SIZE)
     {
-        if (point_centers[3 * i + 0] < bbox[0]) bbox[0] = point_centers[3 * i + 0];
-        if (point_centers[3 * i + 0] > bbox[1]) bbox[1] = point_centers[3 * i + 0];
-        if (point_centers[3 * i + 1] < bbox[2]) bbox[2] = point_centers[3 * i + 1];
-        if (point_centers[3 * i + 1] > bbox[3]) bbox[3] = point_centers[3 * i + 1];
-        if (point_centers[3 * i + 2] < bbox[4]) bbox[4] = point_centers[3 * i + 2];
-        if (point_centers[3 * i + 2] > bbox[5]) bbox[5] = point_centers[3 * i + 2];
+        PointChunk chunk;
+        chunk.first = i;
+        chunk.count = std::min((uint32_t)POINT_CHUNK_SIZE, app.scene.num_points - i);
+        chunk.draw_count = chunk.count;
+        app.scene.chunk_order.push_back(app.scene.chunks.size());
+        app.scene.chunks.push_back(chunk);
     }
 
-    /*
-    // ---------------------------------------------------------
-    printf("CAMERA: pos = (%.3f, %.3f, %.3f) target = (%.3f, %.3f, %.3f)\n",
-           app.scene.camera_position[0], app.scene.camera_position[1], app.scene.camera_position[2],
-           app.scene.camera_target[0], app.scene.camera_target[1], app.scene.camera_target[2]);
-    printf("LIGHTS (%d):\n", app.scene.num_lights);
-    for (int i = 0; i < app.scene.num_lights; i++)
+    std::vector<uint64_t> luminance_histogram(app.num_threads * LUMINANCE_BINS, 0);
+    std::vector<uint64_t> size_histogram(app.num_threads * SIZE_BINS, 0);
+    std::vector<std::thread> threads;
+    for (t = 0; t < app.num_threads; t++)
     {
-        printf("  pos = (%.3f, %.3f, %.3f) color = (%.3f, %.3f, %.3f)\n",
-               app.scene.light_positions[3 * i], app.scene.light_positions[3 * i + 1], app.scene.light_positions[3 * i + 2],
-               app.scene.light_colors[3 * i], app.scene.light_colors[3 * i + 1], app.scene.light_colors[3 * i + 2]);
+        threads.push_back(std::thread(chunkStatistics, point_centers, point_colors, point_sizes, t,
+                                      luminance_histogram.data() + t * LUMINANCE_BINS, size_histogram.data() + t * SIZE_BINS));
     }
-    printf("POINTS (%d):\n", app.scene.num_points);
-    for (int i = 0; i < app.scene.num_points; i++)
+    for (t = 0; t < app.num_threads; t++)
     {
-        printf("  pos = (%.3f, %.3f, %.3f) color = (%.3f, %.3f, %.3f)\n",
-               point_centers[3 * i], point_centers[3 * i + 1], point_centers[3 * i + 2],
-               point_colors[3 * i], point_colors[3 * i + 1], point_colors[3 * i + 2]);
+        threads[t].join();
     }
-    // ---------------------------------------------------------
-    */
 
-    app.scene.pointcloud_vertex_array = createPointCloudVertexArray(point_centers, point_colors, point_sizes);
-    delete[] point_centers;
-    delete[] point_colors;
-    delete[] point_sizes;
+    app.scene.max_point_size = 0.0f;
+    for (i = 0; i < app.scene.chunks.size(); i++)
+    {
+        app.scene.max_point_size = std::max(app.scene.max_point_size, app.scene.chunks[i].max_size);
+    }
+    app.scene.luminance_histogram.assign(LUMINANCE_BINS, 0);
+    app.scene.size_histogram.assign(SIZE_BINS, 0);
+    for (t = 0; t < app.num_threads; t++)
+    {
+        for (i = 0; i < LUMINANCE_BINS; i++)
+        {
+            app.scene.luminance_histogram[i] += luminance_histogram[t * LUMINANCE_BINS + i];
+        }
+        for (i = 0; i < SIZE_BINS; i++)
+        {
+            app.scene.size_histogram[i] += size_histogram[t * SIZE_BINS + i];
+        }
+    }
+    app.statistics_time += MPI_Wtime() - start;
+}
+
+void chunkStatistics(const GLfloat *point_centers, const GLfloat *point_colors, const GLfloat *point_sizes,
+                     int thread, uint64_t *luminance_histogram, uint64_t *size_histogram)
+{
+    // Chunks are interleaved across threads (thread, thread + num_threads, ...)
+    // One loop per chunk gathers its bounds, largest size, and the histograms
+    uint32_t c, j;
+    int axis;
+    for (c = thread; c < app.scene.chunks.size(); c += app.num_threads)
+    {
+        PointChunk *chunk = &(app.scene.chunks[c]);
+        float bounds_min[3] = {9.9e12f, 9.9e12f, 9.9e12f};
+        float bounds_max[3] = {-9.9e12f, -9.9e12f, -9.9e12f};
+        chunk->max_size = 0.0f;
+        for (j = chunk->first; j < chunk->first + chunk->count; j++)
+        {
+            const GLfloat *point = point_centers + 3 * (size_t)j;
+            for (axis = 0; axis < 3; axis++)
+            {
+                bounds_min[axis] = std::min(bounds_min[axis], point[axis]);
+                bounds_max[axis] = std::max(bounds_max[axis], point[axis]);
+            }
+            chunk->max_size = std::max(chunk->max_size, point_sizes[j]);
+            luminance_histogram[luminanceBin(point_colors + 3 * (size_t)j)]++;
+            size_histogram[sizeBin(point_sizes[j])]++;
+        }
+        chunk->bbox_min = glm::vec3(bounds_min[0], bounds_min[1], bounds_min[2]);
+        chunk->bbox_max = glm::vec3(bounds_max[0], bounds_max[1], bounds_max[2]);
+    }
+}
+
+void computeChunkCones()
+{
+    // Normal cone of each chunk from its bounds (surface normals point away from the globe's center):
+    // the directions from pointcloud_center to the chunk's bounding sphere contain all of its normals
+    uint32_t c;
+    glm::vec3 globe_center = glm::vec3(app.scene.pointcloud_center);
+    for (c = 0; c < app.scene.chunks.size(); c++)
+    {
+        PointChunk *chunk = &(app.scene.chunks[c]);
+        glm::vec3 offset = 0.5f * (chunk->bbox_min + chunk->bbox_max) - globe_center;
+        float radius = 0.5f * glm::length(chunk->bbox_max - chunk->bbox_min);
+        float distance = glm::length(offset);
+        // Spheres around the center can have normals in every direction
+        chunk->cone_cutoff = 2.0f;
+        if (distance > radius)
+        {
+            chunk->cone_axis = offset / distance;
+            chunk->cone_cutoff = radius / distance;
+        }
+    }
+}
+
+int luminanceBin(const GLfloat *color)
+{
+    float luminance = 0.2126f * color[0] + 0.7152f * color[1] + 0.0722f * color[2];
+    return std::min(std::max((int)(luminance * LUMINANCE_BINS), 0), LUMINANCE_BINS - 1);
+}
+
+int sizeBin(GLfloat size)
+{
+    // Bin by the float's exponent (no log needed)
+    uint32_t bits;
+    memcpy(&bits, &size, sizeof(float));
+    int exponent = (int)((bits >> 23) & 0xFF) - 127;
+    return std::min(std::max(exponent + 24, 0), SIZE_BINS - 1);
+}
+
+void cullPointChunks()
+{
+    // Keep chunks that intersect the view frustum (tested in model space)
+    // With --backface-chunks, also drop chunks whose surface normals all face away from the camera
+    glm::dmat4 mvp = app.projection_matrix * app.view_matrix * app.model_matrix;
+    glm::dvec4 camera = glm::inverse(app.model_matrix) * glm::dvec4(glm::dvec3(app.scene.camera_position), 1.0);
+    glm::vec3 eye = glm::vec3(camera.x, camera.y, camera.z);
+    glm::vec4 planes[6];
+    frustumPlanes(mvp, planes);
+    int i;
+
+    app.scene.chunk_order.clear();
+    uint32_t points = 0;
+    for (i = 0; i < app.scene.chunks.size(); i++)
+    {
+        const PointChunk *chunk = &(app.scene.chunks[i]);
+        glm::vec3 pad = glm::vec3(0.5f * chunk->max_size, 0.5f * chunk->max_size, 0.5f * chunk->max_size);
+        glm::vec3 bbox_min = chunk->bbox_min - pad;
+        glm::vec3 bbox_max = chunk->bbox_max + pad;
+
+        if (boxOutsideFrustum(planes, bbox_min, bbox_max))
+        {
+            app.culled_frustum_chunks += 1.0;
+            continue;
+        }
+
+        // Back-facing: every normal in the cone points away from the camera (bounding sphere test)
+        // Lossy: points are billboards with no facing test, so back hemisphere points (ambient lit)
+        // show through wherever front points leave gaps in the globe's disk, and culling removes them
+        if (app.backface_chunks)
+        {
+            glm::vec3 center = 0.5f * (bbox_min + bbox_max);
+            float radius = 0.5f * glm::length(bbox_max - bbox_min);
+            glm::vec3 view = center - eye;
+            if (chunk->cone_cutoff <= 1.0f &&
+                glm::dot(view, chunk->cone_axis) >= chunk->cone_cutoff * glm::length(view) + radius)
+            {
+                app.culled_backfacing_chunks += 1.0;
+                continue;
+            }
+        }
+
+        app.scene.chunk_order.push_back(i);
+        points += chunk->count;
+    }
+    app.culled_drawn_chunks += app.scene.chunk_order.size();
+    app.culled_drawn_points += points;
+}
+
+void frustumPlanes(const glm::dmat4& mvp, glm::vec4 planes[6])
+{
+    // Clip planes of the model space frustum (w +/- x, y, z rows of the matrix)
+    int p;
+    for (p = 0; p < 3; p++)
+    {
+        glm::dvec4 row = glm::dvec4(mvp[0][p], mvp[1][p], mvp[2][p], mvp[3][p]);
+        glm::dvec4 w_row = glm::dvec4(mvp[0][3], mvp[1][3], mvp[2][3], mvp[3][3]);
+        planes[2 * p] = glm::vec4(w_row + row);
+        planes[2 * p + 1] = glm::vec4(w_row - row);
+    }
+}
+
+bool boxOutsideFrustum(const glm::vec4 planes[6], const glm::vec3& bbox_min, const glm::vec3& bbox_max)
+{
+    // Outside if the corner farthest along a plane's normal is behind it
+    int p, axis;
+    for (p = 0; p < 6; p++)
+    {
+        float distance = planes[p].w;
+        for (axis = 0; axis < 3; axis++)
+        {
+            distance += planes[p][axis] * ((planes[p][axis] > 0.0f) ? bbox_max[axis] : bbox_min[axis]);
+        }
+        if (distance < 0.0f)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void permutePointChunks(GLfloat *point_centers, GLfloat *point_colors, GLfloat *point_sizes)
+{
+    // Fisher-Yates shuffle within each chunk (seeded per chunk so runs are repeatable)
+    uint32_t i, j;
+    for (i = 0; i < app.scene.chunks.size(); i++)
+    {
+        const PointChunk *chunk = &(app.scene.chunks[i]);
+        std::mt19937 random(app.rank * 65521 + i);
+        for (j = chunk->count - 1; j > 0; j--)
+        {
+            uint32_t a = chunk->first + j;
+            uint32_t b = chunk->first + std::uniform_int_distribution<uint32_t>(0, j)(random);
+            std::swap_ranges(point_centers + 3 * a, point_centers + 3 * a + 3, point_centers + 3 * b);
+            std::swap_ranges(point_colors + 3 * a, point_colors + 3 * a + 3, point_colors + 3 * b);
+            std::swap(point_sizes[a], point_sizes[b]);
+        }
+    }
+}
+
+void decimatePointChunks()
+{
+    // Draw each chunk's leading points in proportion to the screen area its bounds cover
+    glm::dmat4 mvp = app.projection_matrix * app.view_matrix * app.model_matrix;
+    int i, corner;
+    double points = 0.0;
+    for (i = 0; i < app.scene.chunk_order.size(); i++)
+    {
+        PointChunk *chunk = &(app.scene.chunks[app.scene.chunk_order[i]]);
+        double screen_min[2] = {(double)app.window_width, (double)app.window_height};
+        double screen_max[2] = {0.0, 0.0};
+        bool behind_eye = false;
+        for (corner = 0; corner < 8 && !behind_eye; corner++)
+        {
+            glm::dvec4 position = mvp * glm::dvec4((corner & 1) ? chunk->bbox_max.x : chunk->bbox_min.x,
+                                                   (corner & 2) ? chunk->bbox_max.y : chunk->bbox_min.y,
+                                                   (corner & 4) ? chunk->bbox_max.z : chunk->bbox_min.z, 1.0);
+            behind_eye = position.w <= 0.0;
+            double pixel[2] = {0.5 * (position.x / position.w + 1.0) * app.window_width,
+                               0.5 * (position.y / position.w + 1.0) * app.window_height};
+            screen_min[0] = std::min(screen_min[0], pixel[0]);
+            screen_min[1] = std::min(screen_min[1], pixel[1]);
+            screen_max[0] = std::max(screen_max[0], pixel[0]);
+            screen_max[1] = std::max(screen_max[1], pixel[1]);
+        }
+
+        if (behind_eye)
+        {
+            // Bounds straddle the eye plane (projected area is unbounded)
+            chunk->draw_count = chunk->count;
+        }
+        else
+        {
+            // Area clipped to the viewport (empty when the chunk is off screen)
+            double width = std::min(screen_max[0], (double)app.window_width) - std::max(screen_min[0], 0.0);
+            double height = std::min(screen_max[1], (double)app.window_height) - std::max(screen_min[1], 0.0);
+            double area = std::max(width, 0.0) * std::max(height, 0.0);
+            double target = ceil(area * app.points_per_pixel);
+            chunk->draw_count = (uint32_t)std::min(target, (double)chunk->count);
+        }
+        points += chunk->draw_count;
+    }
+    app.decimated_drawn_points += points;
+}
+
+void sortChunksFrontToBack()
+{
+    // Order chunks by distance of their centers from the camera (in model space)
+    glm::dvec4 camera = glm::inverse(app.model_matrix) * glm::dvec4(glm::dvec3(app.scene.camera_position), 1.0);
+    glm::vec3 eye = glm::vec3(camera.x, camera.y, camera.z);
+    std::vector<float> distance(app.scene.chunks.size());
+    int i;
+    for (i = 0; i < app.scene.chunks.size(); i++)
+    {
+        glm::vec3 center = 0.5f * (app.scene.chunks[i].bbox_min + app.scene.chunks[i].bbox_max);
+        distance[i] = glm::length(center - eye);
+    }
+    std::sort(app.scene.chunk_order.begin(), app.scene.chunk_order.end(), [&distance](int a, int b) {
+        return distance[a] < distance[b];
+    });
+}
+
+void drawPointChunk(const PointChunk *chunk)
+{
+    // Draw one chunk of the bound point vertex array
+    if (app.quantize)
+    {
+        // Bounds the chunk's positions were quantized to
+        glm::vec3 extent = chunk->bbox_max - chunk->bbox_min;
+        glUniform3fv(app.pointcloud_program->uniforms["chunk_min"], 1, glm::value_ptr(chunk->bbox_min));
+        glUniform3fv(app.pointcloud_program->uniforms["chunk_extent"], 1, glm::value_ptr(extent));
+    }
+    if (app.point_sprites)
+    {
+        glDrawArrays(GL_POINTS, chunk->first, chunk->draw_count);
+    }
+    else if (app.draw_base_instance != NULL)
+    {
+        app.draw_base_instance(GL_TRIANGLES, app.scene.pointcloud_face_index_count, GL_UNSIGNED_SHORT, 0,
+                               chunk->draw_count, chunk->first);
+    }
+    else
+    {
+        // Without base instances, offset the per-instance attributes to the chunk
+        setPointAttribPointers(chunk->first);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDrawElementsInstanced(GL_TRIANGLES, app.scene.pointcloud_face_index_count, GL_UNSIGNED_SHORT, 0, chunk->draw_count);
+    }
+}
+
+void quantizePoints(const GLfloat *point_centers, const GLfloat *point_colors, const GLfloat *point_sizes,
+                    QuantizedPoint *points)
+{
+    // Positions to 16 bits within their chunk's bounds, colors to 8 bits, sizes to half floats
+    // Done at load time because the bounds are those of the rank's chunks (after partitioning and
+    // sorting), so files on disk keep the float layout; `points` may be write-only mapped memory
+    uint32_t i, j;
+    int axis;
+    QuantizationError *error = &(app.scene.quantization_error);
+    error->max_position = 0.0;
+    error->sum_sq_position = 0.0;
+    error->max_color = 0.0;
+    error->max_size = 0.0;
+    for (i = 0; i < app.scene.chunks.size(); i++)
+    {
+        const PointChunk *chunk = &(app.scene.chunks[i]);
+        glm::vec3 extent = chunk->bbox_max - chunk->bbox_min;
+        for (j = chunk->first; j < chunk->first + chunk->count; j++)
+        {
+            // Measure error against the values the vertex shader reconstructs
+            QuantizedPoint point;
+            double sq_error = 0.0;
+            for (axis = 0; axis < 3; axis++)
+            {
+                float t = (extent[axis] > 0.0f) ? (point_centers[3 * j + axis] - chunk->bbox_min[axis]) / extent[axis] : 0.0f;
+                point.position[axis] = (GLushort)std::min(std::max((int)(t * 65535.0f + 0.5f), 0), 65535);
+                float position = chunk->bbox_min[axis] + extent[axis] * ((float)point.position[axis] / 65535.0f);
+                sq_error += (position - point_centers[3 * j + axis]) * (position - point_centers[3 * j + axis]);
+
+                point.color[axis] = (GLubyte)std::min(std::max((int)(point_colors[3 * j + axis] * 255.0f + 0.5f), 0), 255);
+                float color = (float)point.color[axis] / 255.0f;
+                error->max_color = std::max(error->max_color, (double)fabs(color - point_colors[3 * j + axis]));
+            }
+            point.color[3] = 255;
+            error->max_position = std::max(error->max_position, sqrt(sq_error));
+            error->sum_sq_position += sq_error;
+
+            point.size = floatToHalf(point_sizes[j]);
+            if (point_sizes[j] > 0.0f)
+            {
+                float size = halfToFloat(point.size);
+                error->max_size = std::max(error->max_size, (double)fabs(size - point_sizes[j]) / point_sizes[j]);
+            }
+            memcpy(points + j, &point, sizeof(QuantizedPoint));
+        }
+    }
+}
+
+void setPointAttribPointers(uint32_t first)
+{
+    // Attach the point buffers to the bound vertex array, starting at point `first`
+    if (app.quantize)
+    {
+        size_t offset = sizeof(QuantizedPoint) * (size_t)first;
+        glBindBuffer(GL_ARRAY_BUFFER, app.scene.point_center_buffer);
+        // (as normalized 16-bit position, half float size, and normalized 8-bit color)
+        glVertexAttribPointer(app.point_center_attrib, 3, GL_UNSIGNED_SHORT, true, sizeof(QuantizedPoint),
+                              (const GLvoid*)(offset + offsetof(QuantizedPoint, position)));
+        glVertexAttribPointer(app.point_size_attrib, 1, GL_HALF_FLOAT, false, sizeof(QuantizedPoint),
+                              (const GLvoid*)(offset + offsetof(QuantizedPoint, size)));
+        glVertexAttribPointer(app.point_color_attrib, 3, GL_UNSIGNED_BYTE, true, sizeof(QuantizedPoint),
+                              (const GLvoid*)(offset + offsetof(QuantizedPoint, color)));
+    }
+    else
+    {
+        // (as 3-component, 3-component, and 1-component floating point values)
+        glBindBuffer(GL_ARRAY_BUFFER, app.scene.point_center_buffer);
+        glVertexAttribPointer(app.point_center_attrib, 3, GL_FLOAT, false, 0, (const GLvoid*)(3 * sizeof(GLfloat) * (size_t)first));
+        glBindBuffer(GL_ARRAY_BUFFER, app.scene.point_color_buffer);
+        glVertexAttribPointer(app.point_color_attrib, 3, GL_FLOAT, false, 0, (const GLvoid*)(3 * sizeof(GLfloat) * (size_t)first));
+        glBindBuffer(GL_ARRAY_BUFFER, app.scene.point_size_buffer);
+        glVertexAttribPointer(app.point_size_attrib, 1, GL_FLOAT, false, 0, (const GLvoid*)(sizeof(GLfloat) * (size_t)first));
+    }
+}
+
+GLhalf floatToHalf(float value)
+{
+    // Round to nearest, flush values below the normal half range to zero, clamp large values
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x007FFFFF;
+    if (exponent <= 0)
+    {
+        return sign;
+    }
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x00001000)
+    {
+        half++;
+    }
+    return sign | std::min(half, (uint32_t)0x7BFF);
+}
+
+float halfToFloat(GLhalf value)
+{
+    uint32_t sign = ((uint32_t)value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x03FF;
+    uint32_t bits = (exponent == 0) ? sign : sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    float result;
+    memcpy(&result, &bits, sizeof(float));
+    return result;
 }
 
 GLuint createPointCloudVertexArray(GLfloat *point_centers, GLfloat *point_colors, GLfloat *point_sizes)
@@ -876,49 +3144,64 @@ GLuint createPointCloudVertexArray(GLfloat *point_centers, GLfloat *point_colors
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, 3 * num_faces * sizeof(GLushort), indices, GL_STATIC_DRAW);
 
     // Point cloud data
-    // Create buffer to store point center positions
-    GLuint point_center_buffer;
-    glGenBuffers(1, &point_center_buffer);
-    // Set newly created buffer as the active one we are modifying
-    glBindBuffer(GL_ARRAY_BUFFER, point_center_buffer);
-    // Store array of point centers in the point_center_buffer
-    glBufferData(GL_ARRAY_BUFFER, 3 * app.scene.num_points * sizeof(GLfloat), point_centers, GL_STATIC_DRAW);
-    // Enable point_center_attrib in our GPU program
+    if (app.quantize)
+    {
+        // Create one interleaved buffer of quantized points (shared by all point attributes)
+        // Points are quantized straight into the mapped buffer, so no second host copy is held
+        GLuint point_buffer;
+        glGenBuffers(1, &point_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, point_buffer);
+        glBufferData(GL_ARRAY_BUFFER, app.scene.num_points * sizeof(QuantizedPoint), NULL, GL_STATIC_DRAW);
+        QuantizedPoint *points = (QuantizedPoint*)glMapBufferRange(GL_ARRAY_BUFFER, 0,
+                                                                   app.scene.num_points * sizeof(QuantizedPoint),
+                                                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (points == NULL)
+        {
+            fprintf(stderr, "Error: could not map quantized point buffer\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        quantizePoints(point_centers, point_colors, point_sizes, points);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        app.scene.point_center_buffer = point_buffer;
+        app.scene.point_color_buffer = point_buffer;
+        app.scene.point_size_buffer = point_buffer;
+    }
+    else
+    {
+        // Octree LOD only allocates the node pool
+        bool pool = app.point_budget > 0;
+        size_t buffer_points = pool ? app.scene.pool_slots.size() * OCTREE_NODE_POINTS : app.scene.num_points;
+        GLenum usage = pool ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+
+        // Create buffer to store point center positions
+        glGenBuffers(1, &(app.scene.point_center_buffer));
+        // Set newly created buffer as the active one we are modifying
+        glBindBuffer(GL_ARRAY_BUFFER, app.scene.point_center_buffer);
+        // Store array of point centers in the point_center_buffer
+        glBufferData(GL_ARRAY_BUFFER, 3 * buffer_points * sizeof(GLfloat), pool ? NULL : point_centers, usage);
+
+        // Create buffer to store point colors
+        glGenBuffers(1, &(app.scene.point_color_buffer));
+        // Set newly created buffer as the active one we are modifying
+        glBindBuffer(GL_ARRAY_BUFFER, app.scene.point_color_buffer);
+        // Store array of point colors in the point_color_buffer
+        glBufferData(GL_ARRAY_BUFFER, 3 * buffer_points * sizeof(GLfloat), pool ? NULL : point_colors, usage);
+
+        // Create buffer to store point sizes
+        glGenBuffers(1, &(app.scene.point_size_buffer));
+        // Set newly created buffer as the active one we are modifying
+        glBindBuffer(GL_ARRAY_BUFFER, app.scene.point_size_buffer);
+        // Store array of point sizes in the point_size_buffer
+        glBufferData(GL_ARRAY_BUFFER, buffer_points * sizeof(GLfloat), pool ? NULL : point_sizes, usage);
+    }
+    // Enable point attributes in our GPU program and attach the point buffers to them
     glEnableVertexAttribArray(app.point_center_attrib);
-    // Attach point_center_buffer to the point_center_attrib
-    // (as 3-component floating point values)
-    glVertexAttribPointer(app.point_center_attrib, 3, GL_FLOAT, false, 0, 0);
-    // advance one vertex attribute per instance
-    glVertexAttribDivisor(app.point_center_attrib, 1);
-
-    // Create buffer to store point colors
-    GLuint point_color_buffer;
-    glGenBuffers(1, &point_color_buffer);
-    // Set newly created buffer as the active one we are modifying
-    glBindBuffer(GL_ARRAY_BUFFER, point_color_buffer);
-    // Store array of point colors in the point_color_buffer
-    glBufferData(GL_ARRAY_BUFFER, 3 * app.scene.num_points * sizeof(GLfloat), point_colors, GL_STATIC_DRAW);
-    // Enable point_color_attrib in our GPU program
     glEnableVertexAttribArray(app.point_color_attrib);
-    // Attach point_color_buffer to the point_color_attrib
-    // (as 3-component floating point values)
-    glVertexAttribPointer(app.point_color_attrib, 3, GL_FLOAT, false, 0, 0);
-    // advance one vertex attribute per instance
-    glVertexAttribDivisor(app.point_color_attrib, 1);
-
-    // Create buffer to store point sizes
-    GLuint point_size_buffer;
-    glGenBuffers(1, &point_size_buffer);
-    // Set newly created buffer as the active one we are modifying
-    glBindBuffer(GL_ARRAY_BUFFER, point_size_buffer);
-    // Store array of point sizes in the point_color_buffer
-    glBufferData(GL_ARRAY_BUFFER, app.scene.num_points * sizeof(GLfloat), point_sizes, GL_STATIC_DRAW);
-    // Enable point_size_attrib in our GPU program
     glEnableVertexAttribArray(app.point_size_attrib);
-    // Attach point_size_buffer to the point_size_attrib
-    // (as 1-component floating point values)
-    glVertexAttribPointer(app.point_size_attrib, 1, GL_FLOAT, false, 0, 0);
+    setPointAttribPointers(0);
     // advance one vertex attribute per instance
+    glVertexAttribDivisor(app.point_center_attrib, 1);
+    glVertexAttribDivisor(app.point_color_attrib, 1);
     glVertexAttribDivisor(app.point_size_attrib, 1);
 
     // No longer modifying our Vertex Array Object, so deselect
@@ -933,6 +3216,24 @@ GLuint createPointCloudVertexArray(GLfloat *point_centers, GLfloat *point_colors
     return vertex_array;
 }
 
+GLuint createPointSpriteVertexArray()
+{
+    // Same point buffers as the instanced quads, but one vertex per point (drawn as GL_POINTS)
+    GLuint vertex_array;
+    glGenVertexArrays(1, &vertex_array);
+    glBindVertexArray(vertex_array);
+
+    glEnableVertexAttribArray(app.point_center_attrib);
+    glEnableVertexAttribArray(app.point_color_attrib);
+    glEnableVertexAttribArray(app.point_size_attrib);
+    setPointAttribPointers(0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return vertex_array;
+}
+
 GLuint createPlaneVertexArray()
 {
     // Create vertex array object